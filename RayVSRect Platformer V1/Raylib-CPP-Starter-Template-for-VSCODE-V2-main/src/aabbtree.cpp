@@ -0,0 +1,311 @@
+#include "aabbtree.h"
+
+#include <algorithm>
+
+static Rectangle Union(Rectangle a, Rectangle b){
+    float x0 = std::min(a.x, b.x), y0 = std::min(a.y, b.y);
+    float x1 = std::max(a.x + a.width, b.x + b.width), y1 = std::max(a.y + a.height, b.y + b.height);
+    return Rectangle {x0, y0, x1 - x0, y1 - y0};
+}
+
+//the cost of a box when picking where to insert. the perimeter works better than the area for long thin rectangles.
+static float Perimeter(Rectangle r){
+    return 2*(r.width + r.height);
+}
+
+static bool Overlaps(Rectangle a, Rectangle b){
+    return a.x <= b.x + b.width && b.x <= a.x + a.width && a.y <= b.y + b.height && b.y <= a.y + a.height;
+}
+
+static bool IsLeaf(const AABBNode& node){
+    return node.left == -1;
+}
+
+static int AllocateNode(AABBTree& tree){
+    int index;
+    if(tree.freeList != -1){
+        index = tree.freeList;
+        tree.freeList = tree.nodes[index].parent;
+    }
+    else{
+        index = int(tree.nodes.size());
+        tree.nodes.push_back(AABBNode {});
+    }
+
+    AABBNode& node = tree.nodes[index];
+    node.parent = node.left = node.right = -1;
+    node.id = -1;
+    node.height = 0;
+    return index;
+}
+
+static void FreeNode(AABBTree& tree, int index){
+    tree.nodes[index].parent = tree.freeList;
+    tree.nodes[index].height = -1;
+    tree.freeList = index;
+}
+
+void TreeClear(AABBTree& tree){
+    tree.nodes.clear();
+    tree.root = -1;
+    tree.freeList = -1;
+}
+
+//if one child of a is two or more levels taller than the other, the taller child is rotated up into a's place.
+//returns the node now sitting where a was.
+static int Balance(AABBTree& tree, int iA){
+    std::vector<AABBNode>& n = tree.nodes;
+    AABBNode& A = n[iA];
+    if(IsLeaf(A) || A.height < 2) return iA;
+
+    int iB = A.left, iC = A.right;
+    int balance = n[iC].height - n[iB].height;
+
+    //C is taller, rotate it up
+    if(balance > 1){
+        int iF = n[iC].left, iG = n[iC].right;
+
+        n[iC].left = iA;
+        n[iC].parent = A.parent;
+        A.parent = iC;
+
+        if(n[iC].parent != -1){
+            if(n[n[iC].parent].left == iA) n[n[iC].parent].left = iC;
+            else n[n[iC].parent].right = iC;
+        }
+        else tree.root = iC;
+
+        //the taller of C's children stays under C, the other one moves down to A
+        if(n[iF].height > n[iG].height){
+            n[iC].right = iF;
+            A.right = iG;
+            n[iG].parent = iA;
+            A.box = Union(n[iB].box, n[iG].box);
+            n[iC].box = Union(A.box, n[iF].box);
+            A.height = 1 + std::max(n[iB].height, n[iG].height);
+            n[iC].height = 1 + std::max(A.height, n[iF].height);
+        }
+        else{
+            n[iC].right = iG;
+            A.right = iF;
+            n[iF].parent = iA;
+            A.box = Union(n[iB].box, n[iF].box);
+            n[iC].box = Union(A.box, n[iG].box);
+            A.height = 1 + std::max(n[iB].height, n[iF].height);
+            n[iC].height = 1 + std::max(A.height, n[iG].height);
+        }
+        return iC;
+    }
+
+    //B is taller, same thing the other way round
+    if(balance < -1){
+        int iD = n[iB].left, iE = n[iB].right;
+
+        n[iB].left = iA;
+        n[iB].parent = A.parent;
+        A.parent = iB;
+
+        if(n[iB].parent != -1){
+            if(n[n[iB].parent].left == iA) n[n[iB].parent].left = iB;
+            else n[n[iB].parent].right = iB;
+        }
+        else tree.root = iB;
+
+        if(n[iD].height > n[iE].height){
+            n[iB].right = iD;
+            A.left = iE;
+            n[iE].parent = iA;
+            A.box = Union(n[iC].box, n[iE].box);
+            n[iB].box = Union(A.box, n[iD].box);
+            A.height = 1 + std::max(n[iC].height, n[iE].height);
+            n[iB].height = 1 + std::max(A.height, n[iD].height);
+        }
+        else{
+            n[iB].right = iE;
+            A.left = iD;
+            n[iD].parent = iA;
+            A.box = Union(n[iC].box, n[iD].box);
+            n[iB].box = Union(A.box, n[iE].box);
+            A.height = 1 + std::max(n[iC].height, n[iD].height);
+            n[iB].height = 1 + std::max(A.height, n[iE].height);
+        }
+        return iB;
+    }
+
+    return iA;
+}
+
+//walks from a node up to the root fixing boxes and heights, rebalancing on the way
+static void Refit(AABBTree& tree, int index){
+    std::vector<AABBNode>& n = tree.nodes;
+    while(index != -1){
+        index = Balance(tree, index);
+
+        int left = n[index].left, right = n[index].right;
+        n[index].height = 1 + std::max(n[left].height, n[right].height);
+        n[index].box = Union(n[left].box, n[right].box);
+
+        index = n[index].parent;
+    }
+}
+
+static void InsertLeaf(AABBTree& tree, int leaf){
+    std::vector<AABBNode>& n = tree.nodes;
+    if(tree.root == -1){
+        tree.root = leaf;
+        n[leaf].parent = -1;
+        return;
+    }
+
+    //go down towards whichever child grows the least by taking the new box, stopping when making a new parent
+    //right here is cheaper than either. every level passed on the way pays for the growth of its box too.
+    Rectangle leafBox = n[leaf].box;
+    int index = tree.root;
+    while(!IsLeaf(n[index])){
+        int left = n[index].left, right = n[index].right;
+
+        float area = Perimeter(n[index].box);
+        float combined = Perimeter(Union(n[index].box, leafBox));
+        float cost = 2*combined;
+        float inheritance = 2*(combined - area);
+
+        float costLeft = Perimeter(Union(leafBox, n[left].box)) + inheritance;
+        if(!IsLeaf(n[left])) costLeft -= Perimeter(n[left].box);
+        float costRight = Perimeter(Union(leafBox, n[right].box)) + inheritance;
+        if(!IsLeaf(n[right])) costRight -= Perimeter(n[right].box);
+
+        if(cost < costLeft && cost < costRight) break;
+        index = costLeft < costRight ? left : right;
+    }
+
+    int sibling = index;
+    int oldParent = n[sibling].parent;
+    int newParent = AllocateNode(tree);
+    std::vector<AABBNode>& m = n;
+    m[newParent].parent = oldParent;
+    m[newParent].box = Union(leafBox, m[sibling].box);
+    m[newParent].height = m[sibling].height + 1;
+    m[newParent].left = sibling;
+    m[newParent].right = leaf;
+    m[sibling].parent = newParent;
+    m[leaf].parent = newParent;
+
+    if(oldParent != -1){
+        if(m[oldParent].left == sibling) m[oldParent].left = newParent;
+        else m[oldParent].right = newParent;
+    }
+    else tree.root = newParent;
+
+    Refit(tree, m[leaf].parent);
+}
+
+static void RemoveLeaf(AABBTree& tree, int leaf){
+    std::vector<AABBNode>& n = tree.nodes;
+    if(leaf == tree.root){
+        tree.root = -1;
+        return;
+    }
+
+    //the leaf's parent goes away and the sibling takes its place
+    int parent = n[leaf].parent;
+    int grandParent = n[parent].parent;
+    int sibling = n[parent].left == leaf ? n[parent].right : n[parent].left;
+
+    if(grandParent != -1){
+        if(n[grandParent].left == parent) n[grandParent].left = sibling;
+        else n[grandParent].right = sibling;
+        n[sibling].parent = grandParent;
+        FreeNode(tree, parent);
+        Refit(tree, grandParent);
+    }
+    else{
+        tree.root = sibling;
+        n[sibling].parent = -1;
+        FreeNode(tree, parent);
+    }
+}
+
+int TreeInsert(AABBTree& tree, int id, Rectangle bounds){
+    int leaf = AllocateNode(tree);
+    AABBNode& node = tree.nodes[leaf];
+    node.box = Rectangle {bounds.x - tree.margin, bounds.y - tree.margin, bounds.width + 2*tree.margin, bounds.height + 2*tree.margin};
+    node.id = id;
+    node.height = 0;
+    InsertLeaf(tree, leaf);
+    return leaf;
+}
+
+void TreeRemove(AABBTree& tree, int proxy){
+    RemoveLeaf(tree, proxy);
+    FreeNode(tree, proxy);
+}
+
+void TreeQuery(const AABBTree& tree, Rectangle area, std::vector<int>& out){
+    if(tree.root == -1) return;
+
+    static thread_local std::vector<int> stack;
+    stack.clear();
+    stack.push_back(tree.root);
+    while(!stack.empty()){
+        int index = stack.back();
+        stack.pop_back();
+
+        const AABBNode& node = tree.nodes[index];
+        if(!Overlaps(node.box, area)) continue;
+
+        if(IsLeaf(node)) out.push_back(node.id);
+        else{
+            stack.push_back(node.left);
+            stack.push_back(node.right);
+        }
+    }
+}
+
+//slab test of the segment origin + dir*t for t in [0, maxT] against a box
+static bool SegmentHitsBox(Vector2 origin, Vector2 dir, float maxT, Rectangle box){
+    float tMin = 0, tMax = maxT;
+
+    if(dir.x == 0){
+        if(origin.x < box.x || origin.x > box.x + box.width) return false;
+    }
+    else{
+        float t0 = (box.x - origin.x) / dir.x, t1 = (box.x + box.width - origin.x) / dir.x;
+        if(t0 > t1) std::swap(t0, t1);
+        tMin = std::max(tMin, t0);
+        tMax = std::min(tMax, t1);
+        if(tMin > tMax) return false;
+    }
+
+    if(dir.y == 0){
+        if(origin.y < box.y || origin.y > box.y + box.height) return false;
+    }
+    else{
+        float t0 = (box.y - origin.y) / dir.y, t1 = (box.y + box.height - origin.y) / dir.y;
+        if(t0 > t1) std::swap(t0, t1);
+        tMin = std::max(tMin, t0);
+        tMax = std::min(tMax, t1);
+        if(tMin > tMax) return false;
+    }
+    return true;
+}
+
+void TreeRaycast(const AABBTree& tree, Vector2 origin, Vector2 dir, float maxT, std::vector<int>& out){
+    if(tree.root == -1) return;
+
+    static thread_local std::vector<int> stack;
+    stack.clear();
+    stack.push_back(tree.root);
+    while(!stack.empty()){
+        int index = stack.back();
+        stack.pop_back();
+
+        const AABBNode& node = tree.nodes[index];
+        if(!SegmentHitsBox(origin, dir, maxT, node.box)) continue;
+
+        if(IsLeaf(node)) out.push_back(node.id);
+        else{
+            stack.push_back(node.left);
+            stack.push_back(node.right);
+        }
+    }
+}
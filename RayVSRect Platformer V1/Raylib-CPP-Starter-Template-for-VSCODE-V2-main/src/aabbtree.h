@@ -0,0 +1,41 @@
+#ifndef AABBTREE_H_
+#define AABBTREE_H_
+
+#include "raylib.h"
+#include <vector>
+
+//a dynamic bounding volume tree. every leaf is one rectangle, every inner node the box around its two children,
+//so a query only goes down the branches its area touches. unlike the grid it doesn't care how big the rectangles are,
+//a 300x200 block is one leaf instead of a couple of hundred grid cells.
+//leaves are stored "fat" (grown by margin), so a query for something right up against a rectangle still finds it.
+//it only holds things that stay put (the statics, and sleeping bodies), the moving bodies use sweep and prune.
+struct AABBNode {
+    Rectangle box;
+    int parent;
+    int left, right;    //-1 for leaves
+    int id;             //the caller's id, leaves only
+    int height;         //0 for leaves, -1 for nodes on the free list
+};
+
+struct AABBTree {
+    std::vector<AABBNode> nodes;
+    int root = -1;
+    int freeList = -1;
+    float margin = 2.0f;
+};
+
+void TreeClear(AABBTree& tree);
+
+//returns the proxy (leaf node index) the id is stored under, that's what TreeRemove and TreeSetId take
+int TreeInsert(AABBTree& tree, int id, Rectangle bounds);
+void TreeRemove(AABBTree& tree, int proxy);
+
+inline void TreeSetId(AABBTree& tree, int proxy, int id){ tree.nodes[proxy].id = id; }
+
+//appends the id of every leaf whose fat box overlaps the area. it only reads the tree, so threads can share it.
+void TreeQuery(const AABBTree& tree, Rectangle area, std::vector<int>& out);
+
+//appends the id of every leaf whose fat box the segment from origin to origin + dir*maxT passes through
+void TreeRaycast(const AABBTree& tree, Vector2 origin, Vector2 dir, float maxT, std::vector<int>& out);
+
+#endif
@@ -1,40 +1,124 @@
-#include "animation.h"
-
-#include <stdlib.h>
-
-SpriteAnimation CreateSpriteAnimation(Texture2D atlas, int framesPerSecond, Rectangle rectangles[], int length){
-    SpriteAnimation spriteAnimation = {
-        .atlas = atlas,
-        .framesPerSecond = framesPerSecond,
-        .rectanglesLength = length
-    };
-
-    Rectangle* mem = (Rectangle*)malloc(sizeof(Rectangle) * length);
-
-    if(mem == NULL){
-        TraceLog(LOG_FATAL, "No memory for CreateSpriteAnimation");
-        spriteAnimation.rectanglesLength = 0;
-        return spriteAnimation;
-    }
-
-    spriteAnimation.rectangles = mem;
-
-    for(int i = 0; i < length; i++){
-        spriteAnimation.rectangles[i] = rectangles[i];
-    }
-
-    return spriteAnimation;
-}
-
-void DisposeSpriteAnimation(SpriteAnimation animation){
-    free(animation.rectangles);
-}
-
-void DrawSpriteAnimationPro(SpriteAnimation animation, Rectangle dest, Vector2 origin, float rotation, Color tint){
-
-int index = int(GetTime()) * animation.framesPerSecond % animation.rectanglesLength;
-
-Rectangle source = animation.rectangles[index];
-DrawTexturePro(animation.atlas, source, dest, origin, rotation, tint);
-
-}
\ No newline at end of file
+#include "animation.h"
+
+#include "rlgl.h"
+#include <math.h>
+#include <algorithm>
+
+//how many quads go into one rlBegin/rlEnd run, small enough to always fit in rlgl's default vertex buffer
+static const int QUADS_PER_RUN = 1024;
+
+SpriteAnimation CreateSpriteAnimation(FramePool& pool, Texture2D atlas, float framesPerSecond, const Rectangle rectangles[], int length, bool loop){
+    SpriteAnimation spriteAnimation;
+    spriteAnimation.atlas = atlas;
+    spriteAnimation.framesPerSecond = framesPerSecond;
+    spriteAnimation.firstFrame = int(pool.frames.size());
+    spriteAnimation.frameCount = length;
+    spriteAnimation.loop = loop;
+
+    pool.frames.insert(pool.frames.end(), rectangles, rectangles + length);
+    return spriteAnimation;
+}
+
+void FramePoolReset(FramePool& pool){
+    pool.frames.clear();
+}
+
+void UpdateSpritePlayback(SpritePlayback& playback, float dt){
+    playback.time += dt*playback.speed;
+}
+
+int SpriteAnimationFrame(const SpriteAnimation& animation, const SpritePlayback& playback){
+    if(animation.frameCount <= 0) return 0;
+
+    //the time is kept in seconds, so changing the frame rate doesn't make the animation jump
+    int frame = int(floorf(playback.time*animation.framesPerSecond));
+    if(animation.loop){
+        frame %= animation.frameCount;
+        if(frame < 0) frame += animation.frameCount;
+        return frame;
+    }
+    return std::max(0, std::min(frame, animation.frameCount - 1));
+}
+
+Rectangle SpriteAnimationSource(const FramePool& pool, const SpriteAnimation& animation, const SpritePlayback& playback){
+    if(animation.frameCount <= 0) return Rectangle {0, 0, 0, 0};
+    return pool.frames[animation.firstFrame + SpriteAnimationFrame(animation, playback)];
+}
+
+void DrawSpriteAnimationPro(const FramePool& pool, const SpriteAnimation& animation, const SpritePlayback& playback, Rectangle dest, Vector2 origin, float rotation, Color tint){
+
+Rectangle source = SpriteAnimationSource(pool, animation, playback);
+DrawTexturePro(animation.atlas, source, dest, origin, rotation, tint);
+
+}
+
+void SpriteBatchClear(SpriteBatch& batch){
+    batch.draws.clear();
+}
+
+void SpriteBatchAdd(SpriteBatch& batch, Texture2D texture, Rectangle source, Rectangle dest, Color tint, int layer){
+    if(texture.id == 0 || texture.width <= 0 || texture.height <= 0) return;
+
+    //texture coordinates are worked out here so submitting is just copying them into the vertex buffer
+    SpriteDraw draw;
+    draw.layer = layer;
+    draw.texture = texture.id;
+    draw.order = int(batch.draws.size());
+    float w = float(texture.width), h = float(texture.height);
+    draw.u0 = source.x / w;
+    draw.v0 = source.y / h;
+    draw.u1 = (source.x + fabsf(source.width)) / w;
+    draw.v1 = (source.y + fabsf(source.height)) / h;
+    if(source.width < 0) std::swap(draw.u0, draw.u1);
+    if(source.height < 0) std::swap(draw.v0, draw.v1);
+    draw.dest = dest;
+    draw.tint = tint;
+    batch.draws.push_back(draw);
+}
+
+void SpriteBatchAddAnimation(SpriteBatch& batch, const FramePool& pool, const SpriteAnimation& animation, const SpritePlayback& playback,
+                             Rectangle dest, Color tint, int layer){
+    SpriteBatchAdd(batch, animation.atlas, SpriteAnimationSource(pool, animation, playback), dest, tint, layer);
+}
+
+void SpriteBatchSubmit(SpriteBatch& batch){
+    std::vector<SpriteDraw>& draws = batch.draws;
+    std::sort(draws.begin(), draws.end(), [](const SpriteDraw& a, const SpriteDraw& b){
+        if(a.layer != b.layer) return a.layer < b.layer;
+        if(a.texture != b.texture) return a.texture < b.texture;
+        return a.order < b.order;
+    });
+
+    batch.drawCalls = 0;
+    for(size_t start = 0; start < draws.size();){
+        //one run per texture (per layer), split into pieces rlgl's buffer can hold
+        size_t end = start;
+        while(end < draws.size() && draws[end].texture == draws[start].texture && draws[end].layer == draws[start].layer) end++;
+        batch.drawCalls++;
+
+        rlSetTexture(draws[start].texture);
+        for(size_t piece = start; piece < end; piece += QUADS_PER_RUN){
+            size_t pieceEnd = std::min(end, piece + QUADS_PER_RUN);
+            rlCheckRenderBatchLimit(int(4*(pieceEnd - piece)));
+
+            rlBegin(RL_QUADS);
+            for(size_t k = piece; k < pieceEnd; k++){
+                const SpriteDraw& d = draws[k];
+                const Rectangle& r = d.dest;
+                rlColor4ub(d.tint.r, d.tint.g, d.tint.b, d.tint.a);
+                rlTexCoord2f(d.u0, d.v0);
+                rlVertex2f(r.x, r.y);
+                rlTexCoord2f(d.u0, d.v1);
+                rlVertex2f(r.x, r.y + r.height);
+                rlTexCoord2f(d.u1, d.v1);
+                rlVertex2f(r.x + r.width, r.y + r.height);
+                rlTexCoord2f(d.u1, d.v0);
+                rlVertex2f(r.x + r.width, r.y);
+            }
+            rlEnd();
+        }
+        start = end;
+    }
+    rlSetTexture(0);
+    draws.clear();
+}
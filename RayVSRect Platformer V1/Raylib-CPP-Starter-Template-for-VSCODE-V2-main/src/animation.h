@@ -1,21 +1,72 @@
-#ifndef ANIMATION_H_
-#define ANIMATION_H_
-
-#include "raylib.h"
-
-typedef struct SpriteAnimation{
-    Texture2D atlas;
-    int framesPerSecond;
-
-    Rectangle* rectangles;
-    int rectanglesLength;
-     
-}   SpriteAnimation;
-
-SpriteAnimation CreateSpriteAnimation(Texture2D atlas, int framesPerSecond, Rectangle rectangles[], int length);
-
-void DisposeSpriteAnimation(SpriteAnimation animation);
-
-void DrawSpriteAnimationPro(SpriteAnimation animation, Rectangle dest, Vector2 origin, float rotation, Color tint);
-
-#endif
\ No newline at end of file
+#ifndef ANIMATION_H_
+#define ANIMATION_H_
+
+#include "raylib.h"
+#include <vector>
+
+//every animation's frame rectangles live in one pool. an animation just remembers where its run of frames starts,
+//so making one is a copy into the end of the pool instead of a malloc, and they're all freed at once with FramePoolReset.
+struct FramePool {
+    std::vector<Rectangle> frames;
+};
+
+typedef struct SpriteAnimation{
+    Texture2D atlas;
+    float framesPerSecond;
+
+    int firstFrame;     //index into the pool's frames
+    int frameCount;
+    bool loop;
+
+}   SpriteAnimation;
+
+//where one sprite is in its animation. every entity gets its own, so they don't all flip frames together.
+struct SpritePlayback {
+    float time = 0;
+    float speed = 1;
+};
+
+SpriteAnimation CreateSpriteAnimation(FramePool& pool, Texture2D atlas, float framesPerSecond, const Rectangle rectangles[], int length, bool loop = true);
+
+//forgets every animation made from the pool
+void FramePoolReset(FramePool& pool);
+
+void UpdateSpritePlayback(SpritePlayback& playback, float dt);
+
+//which frame (0 to frameCount - 1) the playback is on. an animation that doesn't loop stays on its last frame.
+int SpriteAnimationFrame(const SpriteAnimation& animation, const SpritePlayback& playback);
+
+Rectangle SpriteAnimationSource(const FramePool& pool, const SpriteAnimation& animation, const SpritePlayback& playback);
+
+//draws one sprite straight away, with rotation. for lots of sprites use a SpriteBatch.
+void DrawSpriteAnimationPro(const FramePool& pool, const SpriteAnimation& animation, const SpritePlayback& playback, Rectangle dest, Vector2 origin, float rotation, Color tint);
+
+//collects sprites and draws them sorted by texture, so every sprite from one atlas goes out in one rlBegin/rlEnd run
+//and rlgl only has to switch textures (and start a new draw call) once per atlas.
+//sprites on a lower layer are drawn first. within a layer and an atlas they keep the order they were added in,
+//but two atlases on the same layer can end up in either order, so give overlapping sprites their own layers.
+struct SpriteDraw {
+    int layer;
+    unsigned int texture;
+    int order;
+    float u0, v0, u1, v1;
+    Rectangle dest;
+    Color tint;
+};
+
+struct SpriteBatch {
+    std::vector<SpriteDraw> draws;
+    int drawCalls = 0;      //texture runs in the last submit, for the debug text
+};
+
+void SpriteBatchClear(SpriteBatch& batch);
+
+//a negative source width or height flips the sprite, the same as DrawTexturePro
+void SpriteBatchAdd(SpriteBatch& batch, Texture2D texture, Rectangle source, Rectangle dest, Color tint, int layer = 0);
+void SpriteBatchAddAnimation(SpriteBatch& batch, const FramePool& pool, const SpriteAnimation& animation, const SpritePlayback& playback,
+                             Rectangle dest, Color tint, int layer = 0);
+
+//draws everything and empties the batch
+void SpriteBatchSubmit(SpriteBatch& batch);
+
+#endif
@@ -0,0 +1,96 @@
+#include "atlas.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+bool LoadSpriteAtlas(SpriteAtlas& atlas, const char* manifestFile){
+    UnloadSpriteAtlas(atlas);
+
+    FILE* file = fopen(manifestFile, "r");
+    if(file == NULL) return false;
+
+    //the page file names are relative to the manifest
+    std::string folder = manifestFile;
+    size_t slash = folder.find_last_of("/\\");
+    folder = slash == std::string::npos ? "" : folder.substr(0, slash + 1);
+
+    bool ok = true;
+    char line[512];
+    while(ok && fgets(line, sizeof(line), file) != NULL){
+        line[strcspn(line, "\r\n")] = 0;
+        if(strncmp(line, "page,", 5) == 0){
+            Texture2D page = LoadTexture((folder + (line + 5)).c_str());
+            if(page.id == 0) ok = false;
+            atlas.pages.push_back(page);
+        }
+        else if(strncmp(line, "sprite,", 7) == 0){
+            //the name runs up to the comma before the five numbers
+            char* fields = line + 7;
+            char* comma = strchr(fields, ',');
+            if(comma == NULL) continue;
+            *comma = 0;
+
+            AtlasSprite sprite;
+            sprite.name = fields;
+            int x, y, w, h;
+            if(sscanf(comma + 1, "%d,%d,%d,%d,%d", &sprite.page, &x, &y, &w, &h) != 5) continue;
+            sprite.rect = Rectangle {float(x), float(y), float(w), float(h)};
+            atlas.sprites.push_back(sprite);
+        }
+    }
+    fclose(file);
+
+    for(const AtlasSprite& sprite : atlas.sprites){
+        if(sprite.page < 0 || sprite.page >= int(atlas.pages.size())) ok = false;
+    }
+    if(!ok){
+        TraceLog(LOG_WARNING, "sprite atlas %s is incomplete, run make atlas", manifestFile);
+        UnloadSpriteAtlas(atlas);
+    }
+    return ok;
+}
+
+void UnloadSpriteAtlas(SpriteAtlas& atlas){
+    for(Texture2D& page : atlas.pages){
+        if(page.id != 0) UnloadTexture(page);
+    }
+    atlas.pages.clear();
+    atlas.sprites.clear();
+}
+
+const AtlasSprite* FindAtlasSprite(const SpriteAtlas& atlas, const char* name){
+    for(const AtlasSprite& sprite : atlas.sprites){
+        if(sprite.name == name) return &sprite;
+    }
+    return NULL;
+}
+
+SpriteAnimation CreateAtlasAnimation(FramePool& pool, const SpriteAtlas& atlas, const char* name, float framesPerSecond, bool loop){
+    std::vector<std::pair<int, const AtlasSprite*>> frames;
+    if(const AtlasSprite* single = FindAtlasSprite(atlas, name)) frames.push_back(std::make_pair(0, single));
+    else{
+        size_t length = strlen(name);
+        for(const AtlasSprite& sprite : atlas.sprites){
+            if(sprite.name.size() <= length || sprite.name.compare(0, length, name) != 0) continue;
+            const char* number = sprite.name.c_str() + length;
+            if(strspn(number, "0123456789") != strlen(number)) continue;
+            frames.push_back(std::make_pair(atoi(number), &sprite));
+        }
+        std::sort(frames.begin(), frames.end(), [](const std::pair<int, const AtlasSprite*>& a, const std::pair<int, const AtlasSprite*>& b){
+            return a.first < b.first;
+        });
+    }
+
+    std::vector<Rectangle> rects;
+    int page = frames.empty() ? -1 : frames[0].second->page;
+    for(const auto& frame : frames){
+        if(frame.second->page == page) rects.push_back(frame.second->rect);
+        else TraceLog(LOG_WARNING, "%s is on a different atlas page to the rest of %s", frame.second->name.c_str(), name);
+    }
+
+    Texture2D texture = {};
+    if(page >= 0) texture = atlas.pages[page];
+    return CreateSpriteAnimation(pool, texture, framesPerSecond, rects.data(), int(rects.size()), loop);
+}
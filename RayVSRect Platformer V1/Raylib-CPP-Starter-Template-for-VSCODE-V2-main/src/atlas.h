@@ -0,0 +1,34 @@
+#ifndef ATLAS_H_
+#define ATLAS_H_
+
+//the sprites packed by tools/atlaspack.cpp ("make atlas"). loading the manifest loads every page once,
+//and the frames for an animation come straight out of it into a FramePool.
+
+#include "raylib.h"
+#include "animation.h"
+#include <string>
+#include <vector>
+
+struct AtlasSprite {
+    std::string name;
+    int page;
+    Rectangle rect;
+};
+
+struct SpriteAtlas {
+    std::vector<Texture2D> pages;
+    std::vector<AtlasSprite> sprites;
+};
+
+//reads a manifest like textures/atlas.txt and loads its pages, which are next to it. returns false if either is missing.
+bool LoadSpriteAtlas(SpriteAtlas& atlas, const char* manifestFile);
+void UnloadSpriteAtlas(SpriteAtlas& atlas);
+
+const AtlasSprite* FindAtlasSprite(const SpriteAtlas& atlas, const char* name);
+
+//an animation of the sprite called name, or if there isn't one, of name1, name2, name3... in that order.
+//the frames have to be on the same page, ones that ended up on another page are left out.
+//frameCount is 0 if nothing matched.
+SpriteAnimation CreateAtlasAnimation(FramePool& pool, const SpriteAtlas& atlas, const char* name, float framesPerSecond, bool loop = true);
+
+#endif
@@ -0,0 +1,198 @@
+#include "broadphase.h"
+
+#include <math.h>
+#include <algorithm>
+
+static long long CellKey(int cx, int cy){
+    return (long long)(((unsigned long long)(unsigned int)cx << 32) | (unsigned int)cy);
+}
+
+//cell coordinates are clamped so something that has fallen out of the world can't overflow them
+static int CellCoord(float v, float cellSize){
+    double c = floor(double(v) / cellSize);
+    if(c < -1e9) return -1000000000;
+    if(c > 1e9) return 1000000000;
+    return int(c);
+}
+
+//the range of cells a rectangle covers, inclusive on both ends
+static void CellRange(const SpatialGrid& grid, Rectangle r, int& x0, int& y0, int& x1, int& y1){
+    x0 = CellCoord(r.x, grid.cellSize);
+    y0 = CellCoord(r.y, grid.cellSize);
+    x1 = CellCoord(r.x + r.width, grid.cellSize);
+    y1 = CellCoord(r.y + r.height, grid.cellSize);
+}
+
+void GridInit(SpatialGrid& grid, float cellSize){
+    grid.cellSize = cellSize;
+    GridClear(grid);
+}
+
+void GridClear(SpatialGrid& grid){
+    grid.cells.clear();
+    grid.stamps.clear();
+    grid.currentStamp = 0;
+}
+
+void GridInsert(SpatialGrid& grid, int id, Rectangle bounds){
+    int x0, y0, x1, y1;
+    CellRange(grid, bounds, x0, y0, x1, y1);
+
+    for(int cy = y0; cy <= y1; cy++){
+        for(int cx = x0; cx <= x1; cx++){
+            grid.cells[CellKey(cx, cy)].push_back(id);
+        }
+    }
+
+    if(id >= int(grid.stamps.size())) grid.stamps.resize(id + 1, 0);
+}
+
+void GridRemove(SpatialGrid& grid, int id, Rectangle bounds){
+    int x0, y0, x1, y1;
+    CellRange(grid, bounds, x0, y0, x1, y1);
+
+    for(int cy = y0; cy <= y1; cy++){
+        for(int cx = x0; cx <= x1; cx++){
+            auto cell = grid.cells.find(CellKey(cx, cy));
+            if(cell == grid.cells.end()) continue;
+
+            std::vector<int>& ids = cell->second;
+            auto it = std::find(ids.begin(), ids.end(), id);
+            if(it != ids.end()){
+                *it = ids.back();
+                ids.pop_back();
+            }
+            if(ids.empty()) grid.cells.erase(cell);
+        }
+    }
+}
+
+void GridQuery(SpatialGrid& grid, Rectangle area, std::vector<int>& out){
+    int x0, y0, x1, y1;
+    CellRange(grid, area, x0, y0, x1, y1);
+
+    grid.currentStamp++;
+    if(grid.currentStamp == 0){
+        //the stamp counter wrapped around, so old stamps could match again
+        std::fill(grid.stamps.begin(), grid.stamps.end(), 0);
+        grid.currentStamp = 1;
+    }
+
+    //a really big area (something falling fast) covers more cells than are actually in use,
+    //so it's cheaper to walk the occupied cells and check which ones are inside
+    double areaCells = (double(x1) - x0 + 1) * (double(y1) - y0 + 1);
+    if(areaCells > double(grid.cells.size())){
+        for(const auto& cell : grid.cells){
+            int cx = int(cell.first >> 32);
+            int cy = int((unsigned int)(cell.first & 0xffffffff));
+            if(cx < x0 || cx > x1 || cy < y0 || cy > y1) continue;
+
+            for(int id : cell.second){
+                if(grid.stamps[id] == grid.currentStamp) continue;
+                grid.stamps[id] = grid.currentStamp;
+                out.push_back(id);
+            }
+        }
+        return;
+    }
+
+    for(int cy = y0; cy <= y1; cy++){
+        for(int cx = x0; cx <= x1; cx++){
+            auto cell = grid.cells.find(CellKey(cx, cy));
+            if(cell == grid.cells.end()) continue;
+
+            for(int id : cell->second){
+                if(grid.stamps[id] == grid.currentStamp) continue;
+                grid.stamps[id] = grid.currentStamp;
+                out.push_back(id);
+            }
+        }
+    }
+}
+
+void GridQueryShared(const SpatialGrid& grid, Rectangle area, std::vector<int>& out){
+    int x0, y0, x1, y1;
+    CellRange(grid, area, x0, y0, x1, y1);
+
+    double areaCells = (double(x1) - x0 + 1) * (double(y1) - y0 + 1);
+    if(areaCells > double(grid.cells.size())){
+        for(const auto& cell : grid.cells){
+            int cx = int(cell.first >> 32);
+            int cy = int((unsigned int)(cell.first & 0xffffffff));
+            if(cx < x0 || cx > x1 || cy < y0 || cy > y1) continue;
+            out.insert(out.end(), cell.second.begin(), cell.second.end());
+        }
+        return;
+    }
+
+    for(int cy = y0; cy <= y1; cy++){
+        for(int cx = x0; cx <= x1; cx++){
+            auto cell = grid.cells.find(CellKey(cx, cy));
+            if(cell == grid.cells.end()) continue;
+            out.insert(out.end(), cell->second.begin(), cell->second.end());
+        }
+    }
+}
+
+//true if the segment passes through the cell, for when the occupied cells are walked instead of the segment's cells
+static bool SegmentHitsCell(Vector2 o, Vector2 d, float maxT, float x0, float y0, float size){
+    float tMin = 0, tMax = maxT;
+    float lo[2] = {x0, y0};
+    float org[2] = {o.x, o.y};
+    float dir[2] = {d.x, d.y};
+    for(int axis = 0; axis < 2; axis++){
+        if(dir[axis] == 0){
+            if(org[axis] < lo[axis] || org[axis] > lo[axis] + size) return 0;
+            continue;
+        }
+        float t0 = (lo[axis] - org[axis]) / dir[axis];
+        float t1 = (lo[axis] + size - org[axis]) / dir[axis];
+        if(t0 > t1) std::swap(t0, t1);
+        tMin = std::max(tMin, t0);
+        tMax = std::min(tMax, t1);
+        if(tMin > tMax) return 0;
+    }
+    return 1;
+}
+
+void GridRaycast(const SpatialGrid& grid, Vector2 origin, Vector2 dir, float maxT, std::vector<int>& out){
+    float size = grid.cellSize;
+    Vector2 end = {origin.x + dir.x*maxT, origin.y + dir.y*maxT};
+    int cx = CellCoord(origin.x, size), cy = CellCoord(origin.y, size);
+    int ex = CellCoord(end.x, size), ey = CellCoord(end.y, size);
+
+    //a ray crossing far more cells than are in use is cheaper to check against the occupied cells
+    double steps = fabs(double(ex) - cx) + fabs(double(ey) - cy) + 1;
+    if(steps > double(grid.cells.size())){
+        for(const auto& cell : grid.cells){
+            int x = int(cell.first >> 32);
+            int y = int((unsigned int)(cell.first & 0xffffffff));
+            if(SegmentHitsCell(origin, dir, maxT, x*size, y*size, size)){
+                out.insert(out.end(), cell.second.begin(), cell.second.end());
+            }
+        }
+        return;
+    }
+
+    //walks the cells in the order the segment enters them: whichever axis reaches its next cell edge first steps
+    int stepX = dir.x > 0 ? 1 : -1, stepY = dir.y > 0 ? 1 : -1;
+    float nextX = dir.x != 0 ? ((cx + (stepX > 0)) * size - origin.x) / dir.x : INFINITY;
+    float nextY = dir.y != 0 ? ((cy + (stepY > 0)) * size - origin.y) / dir.y : INFINITY;
+    float deltaX = dir.x != 0 ? size / fabsf(dir.x) : INFINITY;
+    float deltaY = dir.y != 0 ? size / fabsf(dir.y) : INFINITY;
+
+    for(int i = 0; i < int(steps); i++){
+        auto cell = grid.cells.find(CellKey(cx, cy));
+        if(cell != grid.cells.end()) out.insert(out.end(), cell->second.begin(), cell->second.end());
+        if(cx == ex && cy == ey) break;
+
+        if(nextX < nextY){
+            cx += stepX;
+            nextX += deltaX;
+        }
+        else{
+            cy += stepY;
+            nextY += deltaY;
+        }
+    }
+}
@@ -0,0 +1,49 @@
+#ifndef BROADPHASE_H_
+#define BROADPHASE_H_
+
+#include "raylib.h"
+#include <unordered_map>
+#include <vector>
+
+//collision layers. every static rectangle is on one layer, picked by its type (see SimWorld::typeLayer),
+//and everything that looks statics up says which layers it wants with a mask of these.
+enum CollisionLayer {
+    LAYER_SOLID = 1 << 0,       //stops things, swept against
+    LAYER_HAZARD = 1 << 1,      //kills the player on contact, only ever overlap tested
+    LAYER_TRIGGER = 1 << 2,     //does nothing by itself, for gameplay code to overlap test
+};
+#define LAYER_ALL 0xffffffffu
+
+//a uniform grid over the level. every rectangle is registered in each cell its bounds touch,
+//so a query only has to look at the handful of cells around the moving rectangle instead of the whole level.
+//ids are whatever the caller uses to find the rectangle again (an index into vRects for the game).
+typedef struct SpatialGrid{
+    float cellSize = 16.0f;
+    std::unordered_map<long long, std::vector<int>> cells;
+
+    //stamps are used to stop a rectangle spanning several cells from being returned more than once per query
+    std::vector<unsigned int> stamps;
+    unsigned int currentStamp = 0;
+}   SpatialGrid;
+
+void GridInit(SpatialGrid& grid, float cellSize);
+
+void GridClear(SpatialGrid& grid);
+
+void GridInsert(SpatialGrid& grid, int id, Rectangle bounds);
+
+//bounds must be the same rectangle the id was inserted with
+void GridRemove(SpatialGrid& grid, int id, Rectangle bounds);
+
+//appends every id whose cells overlap the area to out, each id at most once
+void GridQuery(SpatialGrid& grid, Rectangle area, std::vector<int>& out);
+
+//the same query without the stamps, so several threads can run it on one grid at once.
+//an id that spans several cells can come back more than once, sort and unique the result if that matters.
+void GridQueryShared(const SpatialGrid& grid, Rectangle area, std::vector<int>& out);
+
+//appends the ids in every cell the segment from origin to origin + dir*maxT passes through, nearest cells first.
+//like GridQueryShared it only reads the grid and can return an id more than once.
+void GridRaycast(const SpatialGrid& grid, Vector2 origin, Vector2 dir, float maxT, std::vector<int>& out);
+
+#endif
@@ -0,0 +1,119 @@
+#include "contacts.h"
+#include "sim.h"
+
+#include <algorithm>
+
+//a body this far or closer to a surface it was touching last step is still resting on it
+#define CONTACT_SLOP 1.5f
+
+static bool ContactLess(const CachedContact& c, int body, int collider){
+    return c.body < body || (c.body == body && c.collider < collider);
+}
+
+//the first contact of a body, or contacts.size()
+static int FirstContact(const ContactCache& cache, int body){
+    auto it = std::lower_bound(cache.contacts.begin(), cache.contacts.end(), body,
+                               [](const CachedContact& c, int b){ return c.body < b; });
+    return int(it - cache.contacts.begin());
+}
+
+void ContactsBeginStep(ContactCache& cache, int body){
+    for(int i = FirstContact(cache, body); i < int(cache.contacts.size()) && cache.contacts[i].body == body; i++){
+        cache.contacts[i].touched = 0;
+    }
+    cache.warmStarted = 0;
+    cache.resolved = 0;
+}
+
+//how far the body is from the surface along the contact normal, or -1 if it's slid off the side of it
+static float ContactGap(const movingRect& body, Rectangle c, Vector2 normal){
+    const Vector2& p = body.position;
+    const Vector2& s = body.size;
+    if(normal.y != 0){
+        if(!(p.x < c.x + c.width && c.x < p.x + s.x)) return -1;
+        return normal.y < 0 ? c.y - (p.y + s.y) : p.y - (c.y + c.height);
+    }
+    if(!(p.y < c.y + c.height && c.y < p.y + s.y)) return -1;
+    return normal.x < 0 ? c.x - (p.x + s.x) : p.x - (c.x + c.width);
+}
+
+int ContactsWarmStart(SimWorld& world, int body, float dt, std::vector<int>& skip){
+    ContactCache& cache = world.contacts;
+    movingRect& b = world.bodies[body];
+    int clipped = 0;
+
+    for(int i = FirstContact(cache, body); i < int(cache.contacts.size()) && cache.contacts[i].body == body; i++){
+        CachedContact& c = cache.contacts[i];
+        if(c.collider >= SoACount(world.statics)) continue;
+
+        Rectangle now = staticBounds(world, c.collider);
+        if(now.x != c.colliderBounds.x || now.y != c.colliderBounds.y ||
+           now.width != c.colliderBounds.width || now.height != c.colliderBounds.height) continue;
+
+        //only surfaces the body is still right up against and still moving into are worth skipping the sweep for
+        float gap = ContactGap(b, now, c.normal);
+        if(gap < 0 || gap > CONTACT_SLOP) continue;
+        if(b.velocity.x*c.normal.x + b.velocity.y*c.normal.y >= 0) continue;
+
+        //the one ray against the known surface gives exactly what the sweep would have found for it
+        ray hit = DynamicRectVSRect(b, Vector2 {now.x, now.y}, Vector2 {now.width, now.height}, world.statics.type[c.collider], dt);
+        if(!hit.collided || hit.rayCheck > 1 || !(StaticLayer(world, hit.type) & LAYER_SOLID) ||
+           hit.contact_normal.x != c.normal.x || hit.contact_normal.y != c.normal.y) continue;
+
+        ClipVelocity(b, hit);
+        c.touched = 1;
+        skip.push_back(c.collider);
+        clipped++;
+    }
+    cache.warmStarted += clipped;
+    return clipped;
+}
+
+void ContactsTouch(ContactCache& cache, int body, int collider, Rectangle colliderBounds, Vector2 normal){
+    auto it = std::lower_bound(cache.contacts.begin(), cache.contacts.end(), 0,
+                               [&](const CachedContact& c, int){ return ContactLess(c, body, collider); });
+    if(it != cache.contacts.end() && it->body == body && it->collider == collider){
+        //a collider can stop the body on a different face than last step (like landing on top of a wall it was sliding on)
+        if(it->normal.x != normal.x || it->normal.y != normal.y) it->age = -1;
+        it->normal = normal;
+        it->colliderBounds = colliderBounds;
+        it->touched = 1;
+    }
+    else{
+        cache.contacts.insert(it, CachedContact {body, collider, colliderBounds, normal, -1, 1});
+    }
+    cache.resolved++;
+}
+
+void ContactsEndStep(ContactCache& cache, int body){
+    int first = FirstContact(cache, body);
+    int last = first;
+    while(last < int(cache.contacts.size()) && cache.contacts[last].body == body) last++;
+
+    auto end = std::remove_if(cache.contacts.begin() + first, cache.contacts.begin() + last,
+                              [](const CachedContact& c){ return !c.touched; });
+    for(auto it = cache.contacts.begin() + first; it != end; ++it) it->age++;
+    cache.contacts.erase(end, cache.contacts.begin() + last);
+}
+
+void ContactsForget(ContactCache& cache, int body){
+    int first = FirstContact(cache, body);
+    int last = first;
+    while(last < int(cache.contacts.size()) && cache.contacts[last].body == body) last++;
+    cache.contacts.erase(cache.contacts.begin() + first, cache.contacts.begin() + last);
+}
+
+bool ContactsTouching(const ContactCache& cache, int body, Vector2 normal){
+    for(int i = FirstContact(cache, body); i < int(cache.contacts.size()) && cache.contacts[i].body == body; i++){
+        const CachedContact& c = cache.contacts[i];
+        if(c.normal.x == normal.x && c.normal.y == normal.y) return 1;
+    }
+    return 0;
+}
+
+int ContactAge(const ContactCache& cache, int body, int collider){
+    for(int i = FirstContact(cache, body); i < int(cache.contacts.size()) && cache.contacts[i].body == body; i++){
+        if(cache.contacts[i].collider == collider) return cache.contacts[i].age;
+    }
+    return -1;
+}
@@ -0,0 +1,53 @@
+#ifndef CONTACTS_H_
+#define CONTACTS_H_
+
+#include "raylib.h"
+#include <vector>
+
+struct SimWorld;
+
+//a body resting on or sliding along one solid static rectangle. contacts are kept from step to step,
+//so a body that's standing still on the floor doesn't have to find the floor again with a sweep every step,
+//and grounded/wallsliding come from every surface being touched instead of whichever one was resolved last.
+struct CachedContact {
+    int body, collider;
+    //what the collider looked like when the contact was made. if it's been moved, resized or removed the contact is dropped.
+    Rectangle colliderBounds;
+    Vector2 normal;
+    //how many steps in a row the contact has held, 0 on the step it was made
+    int age;
+    bool touched;
+};
+
+struct ContactCache {
+    //sorted by body, then collider
+    std::vector<CachedContact> contacts;
+
+    //counters for the last step, for the debug text
+    int warmStarted = 0;
+    int resolved = 0;
+};
+
+//call before a body's step. every contact of the body starts out untouched.
+void ContactsBeginStep(ContactCache& cache, int body);
+
+//clips the body's velocity against each of its contacts that still holds, the same way resolving a swept hit would,
+//and appends those colliders to skip so they aren't swept against again this step. returns how many it clipped.
+int ContactsWarmStart(SimWorld& world, int body, float dt, std::vector<int>& skip);
+
+//records that the body was stopped by a collider this step
+void ContactsTouch(ContactCache& cache, int body, int collider, Rectangle colliderBounds, Vector2 normal);
+
+//call after a body's step. contacts it didn't touch are dropped, the rest get one step older.
+void ContactsEndStep(ContactCache& cache, int body);
+
+//drops all of a body's contacts, for when it's teleported
+void ContactsForget(ContactCache& cache, int body);
+
+//true if the body is touching anything with this normal
+bool ContactsTouching(const ContactCache& cache, int body, Vector2 normal);
+
+//how many steps the body has been touching the collider, or -1 if it isn't
+int ContactAge(const ContactCache& cache, int body, int collider);
+
+#endif
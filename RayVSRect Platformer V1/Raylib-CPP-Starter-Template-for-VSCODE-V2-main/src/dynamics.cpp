@@ -0,0 +1,561 @@
+#include "dynamics.h"
+#include "sim.h"
+#include "jobs.h"
+#include "profile.h"
+
+#include <raymath.h>
+#include <math.h>
+#include <algorithm>
+
+int addBody(SimWorld& world, float x, float y, float w, float h, int type, float mass){
+    movingRect body = {};
+    body.position = Vector2 {x, y};
+    body.size = Vector2 {w, h};
+    body.type = type;
+    body.mass = mass > 0 ? mass : 1;
+    world.bodies.push_back(body);
+    return int(world.bodies.size()) - 1;
+}
+
+//the BODY_BLOCKED_* bit for moving in direction d
+static unsigned char DirBit(Vector2 d){
+    if(d.x > 0) return BODY_BLOCKED_RIGHT;
+    if(d.x < 0) return BODY_BLOCKED_LEFT;
+    if(d.y > 0) return BODY_BLOCKED_DOWN;
+    if(d.y < 0) return BODY_BLOCKED_UP;
+    return 0;
+}
+
+//the same sweep the player does against the level: every static the swept bounds touch is tested in one batch,
+//then the hits are resolved nearest first, casting again only if an earlier hit changed the velocity.
+//this runs on several threads at once for different bodies, so the scratch space is per thread and the grid query doesn't stamp.
+//budget and stats belong to the body's chunk, for the same reason.
+static void SweepBodyVsStatics(SimWorld& world, int i, float dt, int& budget, TOIStats& stats){
+    movingRect& body = world.bodies[i];
+    if(body.velocity.x == 0 && body.velocity.y == 0) return;
+
+    static thread_local std::vector<int> candidates;
+    candidates.clear();
+    QueryStaticsShared(world, sweptBounds(body, dt), candidates, world.dynamics.collidesWith);
+    if(candidates.empty()) return;
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    const RectSoA& statics = world.statics;
+    static thread_local RectSoA candidateRects;
+    static thread_local RayBatchResult candidateHits;
+    SoAClear(candidateRects);
+    for(int k : candidates){
+        SoAPush(candidateRects, statics.x[k], statics.y[k], statics.w[k], statics.h[k], statics.type[k]);
+    }
+
+    Vector2 center = {body.position.x + body.size.x/2, body.position.y + body.size.y/2};
+    Vector2 rayDir = {body.velocity.x*dt, body.velocity.y*dt};
+    if(RayVsRectBatch(center, rayDir, body.size, 1.0f, candidateRects, candidateHits) == 0) return;
+
+    static thread_local std::vector<collision> z;
+    z.clear();
+    for(int k = 0; k < int(candidates.size()); k++){
+        if(!candidateHits.hit[k]) continue;
+        ray hit = {1, Vector2 {0, 0}, Vector2 {candidateHits.normalX[k], candidateHits.normalY[k]}, candidateHits.tHitNear[k], statics.type[candidates[k]]};
+        z.push_back({candidates[k], hit.rayCheck, hit.type, hit});
+    }
+    std::sort(z.begin(), z.end(), [](const collision& a, const collision& b){
+        return a.second < b.second || (a.second == b.second && a.first < b.first);
+    });
+
+    Vector2 castVelocity = body.velocity;
+    ray firstHit = zeroRay;
+    for(const auto& j : z){
+        ray hit = j.hit;
+        if(body.velocity.x != castVelocity.x || body.velocity.y != castVelocity.y){
+            Rectangle target = staticBounds(world, j.first);
+            if(rectsOverlap(sweptBounds(body, dt), target)){
+                hit = DynamicRectVSRect(body, Vector2 {target.x, target.y}, Vector2 {target.width, target.height}, j.third, dt);
+            }
+            else hit = zeroRay;
+        }
+        if(!hit.collided) continue;
+        if(!firstHit.collided) firstHit = hit;
+
+        //statics don't kill bodies, everything on the layers they collide with is solid to them
+        Vector2 n = hit.contact_normal;
+        body.velocity = Vector2Add(Vector2Add(body.velocity, n), Vector2Multiply(n, Vector2Scale(Vector2 {fabsf(body.velocity.x), fabsf(body.velocity.y)}, 1 - hit.rayCheck)));
+        world.dynamics.blocked[i] |= DirBit(Vector2Negate(n));
+        world.dynamics.velocityVersion[i]++;
+    }
+
+    //a slide can reach something the first sweep didn't, see SimWorld::toiPasses
+    if(firstHit.collided && firstHit.rayCheck <= 1){
+        SlideAlong(body, castVelocity, firstHit, candidateRects, candidateHits, dt, world.toiPasses, budget, stats, [&](int, const ray& hit){
+            world.dynamics.blocked[i] |= DirBit(Vector2Negate(hit.contact_normal));
+            world.dynamics.velocityVersion[i]++;
+        });
+    }
+}
+
+//sweeps a against b in b's frame of reference, so two moving bodies are one ray against one still rectangle.
+//it's the same test DynamicRectVSRect does, but without building a movingRect or working out a contact point nothing here uses,
+//since it runs for every pair every pass.
+static bool SweepPair(const movingRect& a, const movingRect& b, float dt, float& t, Vector2& normal){
+    float dirX = (a.velocity.x - b.velocity.x)*dt;
+    float dirY = (a.velocity.y - b.velocity.y)*dt;
+    if(dirX == 0 && dirY == 0) return false;
+
+    float originX = a.position.x + a.size.x/2, originY = a.position.y + a.size.y/2;
+    float left = b.position.x - a.size.x/2, top = b.position.y - a.size.y/2;
+
+    float nearX = (left - originX) / dirX, farX = (left + b.size.x + a.size.x - originX) / dirX;
+    float nearY = (top - originY) / dirY, farY = (top + b.size.y + a.size.y - originY) / dirY;
+    if(std::isnan(nearX) || std::isnan(farX) || std::isnan(nearY) || std::isnan(farY)) return false;
+
+    if(nearX > farX) std::swap(nearX, farX);
+    if(nearY > farY) std::swap(nearY, farY);
+    if(nearX > farY || nearY > farX) return false;
+
+    float tNear = std::max(nearX, nearY);
+    float tFar = std::min(farX, farY);
+    if(tFar < 0 || tNear > 1) return false;
+
+    if(nearX > nearY) normal = Vector2 {dirX < 0 ? 1.0f : -1.0f, 0};
+    else if(nearX < nearY) normal = Vector2 {0, dirY < 0 ? 1.0f : -1.0f};
+    else return false;
+
+    t = tNear;
+    return true;
+}
+
+//fills in the contact's t, normal and depth for the bodies' current velocities. returns false if they don't touch this step.
+//bodies that overlap by more than the one unit buffer are pushed out along whichever axis they overlap least on,
+//the sweep can't tell which way to go once the ray starts inside.
+static bool TestPair(const SimWorld& world, BodyContact& c, float dt){
+    const movingRect& a = world.bodies[c.a];
+    const movingRect& b = world.bodies[c.b];
+
+    float overlapX = std::min(a.position.x + a.size.x, b.position.x + b.size.x) - std::max(a.position.x, b.position.x);
+    float overlapY = std::min(a.position.y + a.size.y, b.position.y + b.size.y) - std::max(a.position.y, b.position.y);
+    if(overlapX > 1 && overlapY > 1){
+        Vector2 offset = Vector2Subtract(Vector2Add(a.position, Vector2Scale(a.size, 0.5f)), Vector2Add(b.position, Vector2Scale(b.size, 0.5f)));
+        if(overlapX < overlapY) c.normal = Vector2 {offset.x < 0 ? -1.0f : 1.0f, 0};
+        else c.normal = Vector2 {0, offset.y < 0 ? -1.0f : 1.0f};
+        c.depth = std::min(overlapX, overlapY);
+        c.t = -1;
+        return true;
+    }
+
+    float t;
+    if(!SweepPair(a, b, dt, t, c.normal)){
+        c.t = 2.0f;
+        return false;
+    }
+    c.t = std::max(t, 0.0f);
+    c.depth = 0;
+    return true;
+}
+
+static void FindBodyContacts(SimWorld& world, float dt){
+    BodyDynamics& dyn = world.dynamics;
+
+    const std::vector<int>& active = dyn.active;
+    ParallelFor(world.jobs, int(active.size()), dyn.jobGrain, [&](int, int begin, int end){
+        for(int k = begin; k < end; k++) dyn.swept[active[k]] = sweptBounds(world.bodies[active[k]], dt);
+    });
+
+    //sleeping bodies aren't in the order at all, so it starts again from index order when the awake ones change
+    if(dyn.activeChanged || dyn.order.size() != active.size()){
+        dyn.order = active;
+        dyn.activeChanged = false;
+    }
+
+    //insertion sort, ties go by index so the order (and so the contact list) doesn't depend on the last step's order
+    for(size_t k = 1; k < dyn.order.size(); k++){
+        int id = dyn.order[k];
+        float x = dyn.swept[id].x;
+        size_t m = k;
+        while(m > 0 && (dyn.swept[dyn.order[m - 1]].x > x || (dyn.swept[dyn.order[m - 1]].x == x && dyn.order[m - 1] > id))){
+            dyn.order[m] = dyn.order[m - 1];
+            m--;
+        }
+        dyn.order[m] = id;
+    }
+
+    //the bounds are copied out in sorted order so the scan below reads straight through memory
+    dyn.sortedSwept.resize(dyn.order.size());
+    for(size_t k = 0; k < dyn.order.size(); k++) dyn.sortedSwept[k] = dyn.swept[dyn.order[k]];
+
+    //each chunk of sorted entries scans forward for its own pairs into its own list,
+    //so joining the lists in chunk order gives exactly the list one thread would have made
+    const Rectangle* sorted = dyn.sortedSwept.data();
+    int sortedCount = int(dyn.sortedSwept.size());
+    dyn.chunkContacts.resize(ParallelChunks(sortedCount, dyn.jobGrain));
+    ParallelFor(world.jobs, sortedCount, dyn.jobGrain, [&](int chunk, int begin, int end){
+        std::vector<BodyContact>& found = dyn.chunkContacts[chunk];
+        found.clear();
+        for(int k = begin; k < end; k++){
+            const Rectangle sa = sorted[k];
+            float right = sa.x + sa.width, bottom = sa.y + sa.height;
+            for(int m = k + 1; m < sortedCount; m++){
+                const Rectangle& sb = sorted[m];
+                if(sb.x > right) break;
+                if(sb.y > bottom || sa.y > sb.y + sb.height) continue;
+
+                //pairs that aren't closing yet are kept too, with t past the end of the step so they come after the real hits.
+                //if one of those hits stops a body, whatever was falling along with it is tested again and caught.
+                int a = dyn.order[k], b = dyn.order[m];
+                int lo = std::min(a, b), hi = std::max(a, b);
+                BodyContact c = {lo, hi, 2.0f, Vector2 {0, 0}, 0, dyn.velocityVersion[lo], dyn.velocityVersion[hi]};
+                TestPair(world, c, dt);
+                found.push_back(c);
+            }
+        }
+    });
+
+    dyn.contacts.clear();
+    for(const auto& found : dyn.chunkContacts) dyn.contacts.insert(dyn.contacts.end(), found.begin(), found.end());
+    dyn.pairsTested = int(dyn.contacts.size());
+
+    //only the real hits need to be in time of impact order, the rest just go after them in the order they were found
+    auto hitsEnd = std::stable_partition(dyn.contacts.begin(), dyn.contacts.end(), [](const BodyContact& c){ return c.t <= 1; });
+    std::sort(dyn.contacts.begin(), hitsEnd, [](const BodyContact& p, const BodyContact& q){
+        if(p.t != q.t) return p.t < q.t;
+        if(p.a != q.a) return p.a < q.a;
+        return p.b < q.b;
+    });
+}
+
+//contacts are resolved in time of impact order. the closing speed along the normal is cut down to what gets the two bodies
+//to touching by the end of the step, and the change is split by mass. a body that something solid is stopping
+//can't be pushed any further that way, so the other one takes all of it.
+//returns false if the pair didn't need anything done.
+static bool ResolveBodyContact(SimWorld& world, BodyContact& c, float dt, bool firstPass){
+    BodyDynamics& dyn = world.dynamics;
+
+    bool changed = dyn.velocityVersion[c.a] != c.versionA || dyn.velocityVersion[c.b] != c.versionB;
+    if(!changed && (!firstPass || c.t > 1)) return false;
+    if(changed){
+        c.versionA = dyn.velocityVersion[c.a];
+        c.versionB = dyn.velocityVersion[c.b];
+        if(!TestPair(world, c, dt)) return false;
+    }
+
+    Vector2 n = c.normal;
+    movingRect& a = world.bodies[c.a];
+    movingRect& b = world.bodies[c.b];
+    float closing = Vector2DotProduct(Vector2Subtract(a.velocity, b.velocity), n);
+
+    //overlapping bodies need to be moving apart at least fast enough to close part of the gap this step.
+    //everything else gets its closing speed cut to what reaches touching, plus the same one unit buffer the player gets against statics.
+    float change;
+    if(c.t < 0) change = dyn.separation*c.depth/dt - closing;
+    else change = -closing*(1 - c.t) + 1;
+    if(change <= 0 || (c.t >= 0 && closing >= 0)) return false;
+
+    float shareA = b.mass / (a.mass + b.mass);
+    bool aStopped = dyn.blocked[c.a] & DirBit(n);
+    bool bStopped = dyn.blocked[c.b] & DirBit(Vector2Negate(n));
+    if(aStopped && !bStopped) shareA = 0;
+    else if(bStopped && !aStopped) shareA = 1;
+
+    a.velocity = Vector2Add(a.velocity, Vector2Scale(n, change*shareA));
+    b.velocity = Vector2Subtract(b.velocity, Vector2Scale(n, change*(1 - shareA)));
+
+    //resting on something that can't move means not being able to move that way either
+    dyn.blocked[c.b] |= dyn.blocked[c.a] & DirBit(n);
+    dyn.blocked[c.a] |= dyn.blocked[c.b] & DirBit(Vector2Negate(n));
+
+    //the pair has been dealt with at the new velocities, so it only comes up again if something else moves one of them
+    c.versionA = ++dyn.velocityVersion[c.a];
+    c.versionB = ++dyn.velocityVersion[c.b];
+    return true;
+}
+
+static void ResolveBodyContacts(SimWorld& world, float dt, std::vector<unsigned char>& pushed){
+    BodyDynamics& dyn = world.dynamics;
+    dyn.contactsResolved = 0;
+
+    for(int pass = 0; pass < dyn.passes; pass++){
+        int resolved = 0;
+        for(BodyContact& c : dyn.contacts){
+            if(!ResolveBodyContact(world, c, dt, pass == 0)) continue;
+            pushed[c.a] = 1;
+            pushed[c.b] = 1;
+            resolved++;
+        }
+        dyn.contactsResolved += resolved;
+        if(resolved == 0) break;
+    }
+}
+
+static void WakeIsland(BodyDynamics& dyn, int id){
+    BodyIsland& island = dyn.islands[id];
+    for(int i : island.bodies){
+        TreeRemove(dyn.sleepTree, dyn.sleepProxy[i]);
+        dyn.sleepProxy[i] = -1;
+        dyn.island[i] = -1;
+        dyn.restTime[i] = 0;
+        dyn.blocked[i] = 0;
+        dyn.active.push_back(i);
+    }
+    island.bodies.clear();
+    dyn.freeIslands.push_back(id);
+    dyn.sleepingIslands--;
+    dyn.activeChanged = true;
+}
+
+//the islands are woken in the order they're found in, and the active list is sorted afterwards, so it's deterministic
+static void SortActive(BodyDynamics& dyn){
+    if(dyn.activeChanged) std::sort(dyn.active.begin(), dyn.active.end());
+}
+
+void WakeAllBodies(SimWorld& world){
+    BodyDynamics& dyn = world.dynamics;
+    int count = int(world.bodies.size());
+    dyn.restTime.assign(count, 0);
+    dyn.restAnchor.assign(count, Vector2 {0, 0});
+    dyn.island.assign(count, -1);
+    dyn.sleepProxy.assign(count, -1);
+    dyn.pushed.assign(count, 0);
+    dyn.islands.clear();
+    dyn.freeIslands.clear();
+    TreeClear(dyn.sleepTree);
+    dyn.active.clear();
+    for(int i = 0; i < count; i++){
+        if(i != world.playerBody) dyn.active.push_back(i);
+    }
+    dyn.activeChanged = true;
+    dyn.sleepRevision = world.levelRevision;
+    dyn.sleepingIslands = 0;
+}
+
+void WakeBody(SimWorld& world, int body){
+    BodyDynamics& dyn = world.dynamics;
+    if(body < 0 || body >= int(dyn.island.size()) || dyn.island[body] < 0) return;
+    dyn.blocked.resize(world.bodies.size(), 0);
+    WakeIsland(dyn, dyn.island[body]);
+    SortActive(dyn);
+}
+
+//catches the sleep state up with bodies added since the last step, and wakes whatever the level changed under
+static void SyncSleep(SimWorld& world){
+    BodyDynamics& dyn = world.dynamics;
+    int count = int(world.bodies.size());
+    if(int(dyn.island.size()) > count) WakeAllBodies(world);
+    if(int(dyn.island.size()) < count){
+        for(int i = int(dyn.island.size()); i < count; i++){
+            if(i != world.playerBody) dyn.active.push_back(i);
+        }
+        dyn.restTime.resize(count, 0);
+        dyn.restAnchor.resize(count, Vector2 {0, 0});
+        dyn.island.resize(count, -1);
+        dyn.sleepProxy.resize(count, -1);
+        dyn.activeChanged = true;
+    }
+
+    //padded like the swept bounds, so the floor a pile is resting on counts as being under it
+    if(dyn.sleepRevision != world.levelRevision){
+        for(int id = 0; id < int(dyn.islands.size()); id++){
+            if(dyn.islands[id].bodies.empty()) continue;
+            Rectangle area = dyn.islands[id].bounds;
+            area = Rectangle {area.x - 1, area.y - 1, area.width + 2, area.height + 2};
+            if(levelChangedSince(world, dyn.sleepRevision, area)) WakeIsland(dyn, id);
+        }
+        dyn.sleepRevision = world.levelRevision;
+    }
+    SortActive(dyn);
+}
+
+//wakes every sleeping island an awake body's swept bounds reach. the ones woken here have no velocity yet,
+//so they just sit in the contact pass as something to run into and start moving on the next step.
+static void WakeTouched(SimWorld& world, float dt){
+    BodyDynamics& dyn = world.dynamics;
+    if(dyn.sleepingIslands == 0) return;
+
+    std::vector<int>& found = dyn.sleepFound;
+    int awake = int(dyn.active.size());
+    for(int k = 0; k < awake; k++){
+        Rectangle area = sweptBounds(world.bodies[dyn.active[k]], dt);
+        found.clear();
+        TreeQuery(dyn.sleepTree, area, found);
+        for(int i : found){
+            if(dyn.island[i] >= 0 && rectsOverlap(area, rectBounds(world.bodies[i]))) WakeIsland(dyn, dyn.island[i]);
+        }
+    }
+    SortActive(dyn);
+}
+
+//union-find over body indices, only the entries for awake bodies are used
+static int FindRoot(std::vector<int>& parent, int i){
+    while(parent[i] != i){
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+//works out the islands from this step's pairs and puts the ones that have all been at rest long enough to sleep
+static void UpdateSleep(SimWorld& world, float dt){
+    BodyDynamics& dyn = world.dynamics;
+    int count = int(world.bodies.size());
+    std::vector<int>& parent = dyn.islandParent;
+    std::vector<int>& newIsland = dyn.newIsland;
+    std::vector<unsigned char>& restless = dyn.restless;
+    parent.resize(count);
+    newIsland.resize(count);
+    restless.resize(count);
+
+    float drift = dyn.sleepSpeed*dyn.sleepTime;
+    for(int i : dyn.active){
+        parent[i] = i;
+        newIsland[i] = -1;
+        restless[i] = 0;
+        //a body that moves too far from where it came to rest starts again from where it is
+        Vector2 d = Vector2Subtract(world.bodies[i].position, dyn.restAnchor[i]);
+        if(dyn.restTime[i] > 0 && d.x*d.x + d.y*d.y <= drift*drift) dyn.restTime[i] += dt;
+        else{
+            dyn.restAnchor[i] = world.bodies[i].position;
+            dyn.restTime[i] = dt;
+        }
+    }
+    //every pair the sweep and prune found touches, whether or not it needed resolving
+    for(const BodyContact& c : dyn.contacts){
+        int ra = FindRoot(parent, c.a), rb = FindRoot(parent, c.b);
+        if(ra != rb) parent[std::max(ra, rb)] = std::min(ra, rb);
+    }
+    for(int i : dyn.active){
+        if(dyn.restTime[i] < dyn.sleepTime) restless[FindRoot(parent, i)] = 1;
+    }
+
+    bool slept = false;
+    for(int i : dyn.active){
+        int root = FindRoot(parent, i);
+        if(restless[root]) continue;
+
+        if(newIsland[root] < 0){
+            int id;
+            if(!dyn.freeIslands.empty()){
+                id = dyn.freeIslands.back();
+                dyn.freeIslands.pop_back();
+            }
+            else{
+                id = int(dyn.islands.size());
+                dyn.islands.push_back(BodyIsland {});
+            }
+            newIsland[root] = id;
+            dyn.islands[id].bounds = rectBounds(world.bodies[i]);
+            dyn.sleepingIslands++;
+        }
+
+        int id = newIsland[root];
+        BodyIsland& island = dyn.islands[id];
+        movingRect& body = world.bodies[i];
+        Rectangle bounds = rectBounds(body);
+        float right = std::max(island.bounds.x + island.bounds.width, bounds.x + bounds.width);
+        float bottom = std::max(island.bounds.y + island.bounds.height, bounds.y + bounds.height);
+        island.bounds.x = std::min(island.bounds.x, bounds.x);
+        island.bounds.y = std::min(island.bounds.y, bounds.y);
+        island.bounds.width = right - island.bounds.x;
+        island.bounds.height = bottom - island.bounds.y;
+        island.bodies.push_back(i);
+
+        //what's left of its velocity is just the jitter from being clipped, it wakes up at rest
+        body.velocity = Vector2 {0, 0};
+        dyn.island[i] = id;
+        dyn.sleepProxy[i] = TreeInsert(dyn.sleepTree, i, bounds);
+        slept = true;
+    }
+
+    if(slept){
+        dyn.active.erase(std::remove_if(dyn.active.begin(), dyn.active.end(), [&](int i){ return dyn.island[i] >= 0; }), dyn.active.end());
+        dyn.activeChanged = true;
+    }
+}
+
+//fills budgets with each chunk's share of budget, by how many of the count bodies it has.
+//the chunks don't depend on the thread count, so neither does which bodies run out.
+static void SplitBudget(std::vector<int>& budgets, int budget, int count, int grain){
+    int chunks = ParallelChunks(count, grain);
+    budgets.resize(chunks);
+    for(int c = 0; c < chunks; c++){
+        int size = std::min(count, (c + 1)*grain) - c*grain;
+        budgets[c] = int((long long)budget*size/count);
+    }
+}
+
+static void AddStats(TOIStats& total, const std::vector<TOIStats>& chunks){
+    for(const TOIStats& c : chunks){
+        total.sweeps += c.sweeps;
+        total.movers += c.movers;
+        total.mostSweeps = std::max(total.mostSweeps, c.mostSweeps);
+        total.capped += c.capped;
+        total.outOfBudget += c.outOfBudget;
+    }
+}
+
+void StepBodies(SimWorld& world, float dt){
+    PROFILE_SCOPE("StepBodies");
+    BodyDynamics& dyn = world.dynamics;
+    int count = int(world.bodies.size());
+    if(count <= 1){
+        dyn.order.clear();
+        dyn.contacts.clear();
+        return;
+    }
+
+    //only the entries for awake bodies are reset or written to, so none of this costs anything per sleeping body
+    std::vector<unsigned char>& pushed = dyn.pushed;
+    dyn.swept.resize(count);
+    dyn.blocked.resize(count, 0);
+    dyn.velocityVersion.resize(count, 0);
+    pushed.resize(count, 0);
+    SyncSleep(world);
+    for(int i : dyn.active) dyn.blocked[i] = 0;
+
+    //whatever continuous collision budget the player left is split between the chunks
+    std::vector<int>& chunkBudget = dyn.chunkBudget;
+    std::vector<TOIStats>& chunkStats = dyn.chunkStats;
+    const std::vector<int>& active = dyn.active;
+    int awake = int(active.size());
+    SplitBudget(chunkBudget, std::max(world.toiBudget - world.toi.sweeps, 0), awake, dyn.jobGrain);
+    chunkStats.assign(chunkBudget.size(), TOIStats {});
+
+    //everything but the contact resolution only touches one body at a time, so it's split across the job system.
+    //the resolution stays on one thread because the order the contacts are handled in changes the result.
+    ParallelFor(world.jobs, awake, dyn.jobGrain, [&](int chunk, int begin, int end){
+        for(int k = begin; k < end; k++){
+            int i = active[k];
+            movingRect& body = world.bodies[i];
+            body.acc = Vector2 {body.force.x / body.mass, body.force.y / body.mass + world.gravity};
+            body.velocity.x += body.acc.x * dt;
+            body.velocity.y += body.acc.y * dt;
+            body.force = Vector2 {0, 0};
+            SweepBodyVsStatics(world, i, dt, chunkBudget[chunk], chunkStats[chunk]);
+        }
+    });
+    AddStats(world.toi, chunkStats);
+
+    WakeTouched(world, dt);
+    FindBodyContacts(world, dt);
+    ResolveBodyContacts(world, dt, pushed);
+
+    //being pushed by another body can't be allowed to push a body through the level.
+    //bodies woken above are in active now, so the chunks (and what's left of the budget) are worked out again.
+    int left = 0;
+    for(int b : chunkBudget) left += b;
+    awake = int(active.size());
+    SplitBudget(chunkBudget, left, awake, dyn.jobGrain);
+    chunkStats.assign(chunkBudget.size(), TOIStats {});
+    ParallelFor(world.jobs, awake, dyn.jobGrain, [&](int chunk, int begin, int end){
+        for(int k = begin; k < end; k++){
+            int i = active[k];
+            if(pushed[i]) SweepBodyVsStatics(world, i, dt, chunkBudget[chunk], chunkStats[chunk]);
+            pushed[i] = 0;
+
+            movingRect& body = world.bodies[i];
+            body.position.x += body.velocity.x * dt;
+            body.position.y += body.velocity.y * dt;
+        }
+    });
+    AddStats(world.toi, chunkStats);
+
+    if(dyn.allowSleep) UpdateSleep(world, dt);
+}
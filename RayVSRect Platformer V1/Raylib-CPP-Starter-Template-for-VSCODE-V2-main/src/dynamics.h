@@ -0,0 +1,130 @@
+#ifndef DYNAMICS_H_
+#define DYNAMICS_H_
+
+#include "raylib.h"
+#include "broadphase.h"
+#include "aabbtree.h"
+#include <vector>
+
+struct SimWorld;
+
+//every body except the player is a dynamic body: gravity and its force accumulate into its velocity,
+//then it's swept against the level and against the other bodies before it moves.
+//the player keeps its own movement code in SimStep and doesn't take part in this yet.
+
+//a pair of bodies whose swept bounds touch. normal is the face of b that a runs into, pointing back at a.
+//t is past 1 when they weren't closing on each other when the pair was found.
+//bodies that already overlap get t = -1 and depth is how far they're in along the normal.
+struct BodyContact {
+    int a, b;
+    float t;
+    Vector2 normal;
+    float depth;
+    //the velocity versions of a and b when t and normal were worked out
+    unsigned int versionA, versionB;
+};
+
+//what continuous collision did over the last step, for the debug text. see SimWorld::toiPasses.
+struct TOIStats {
+    int sweeps = 0;         //sweeps after the first one, over everything that moved
+    int movers = 0;         //how many movers slid into something their first sweep didn't reach
+    int mostSweeps = 0;     //the most sweeps one mover needed, counting the first
+    int capped = 0;         //movers still running into something after toiPasses, stopped at that contact
+    int outOfBudget = 0;    //movers that got no more sweeps because toiBudget was used up
+};
+
+//bodies that touch (their swept bounds overlap) are in the same island, and an island sleeps or wakes as a whole,
+//see BodyDynamics::sleepSpeed
+struct BodyIsland {
+    std::vector<int> bodies;    //empty for one on the free list
+    Rectangle bounds;
+};
+
+struct BodyDynamics {
+    //sweep and prune order: body indices sorted by the left edge of their swept bounds.
+    //bodies only move a little each step, so last step's order is nearly sorted already and the insertion sort is close to linear.
+    std::vector<int> order;
+    std::vector<Rectangle> swept, sortedSwept;
+
+    //directions each body can't move in this step because something solid is in the way (BODY_BLOCKED_* bits)
+    std::vector<unsigned char> blocked;
+    //bodies another body pushed this step, they're swept against the level again before they move.
+    //every entry is back to 0 by the end of a step.
+    std::vector<unsigned char> pushed;
+    //bumped whenever a body's velocity is changed, so a contact found before that knows it has to be tested again
+    std::vector<unsigned int> velocityVersion;
+
+    std::vector<BodyContact> contacts;
+    //the pairs found by each chunk of the sweep and prune scan, joined back together in chunk order
+    std::vector<std::vector<BodyContact>> chunkContacts;
+
+    //how many bodies (or sorted entries, for the pair scan) each job gets when the world has a job system
+    int jobGrain = 256;
+    //each chunk's share of the step's continuous collision budget, and what it did with it (merged into SimWorld::toi)
+    std::vector<int> chunkBudget;
+    std::vector<TOIStats> chunkStats;
+
+    //how many times the contacts are gone over per step. one pass in time of impact order isn't enough for a stack at rest:
+    //the box on top can be handled before the box under it has been stopped by the floor.
+    //a pass only re-tests the pairs whose bodies changed since the last time, and it stops early once nothing changes.
+    int passes = 4;
+
+    //which layers of statics the bodies are stopped by. spikes are solid to them, they only kill the player.
+    unsigned int collidesWith = LAYER_SOLID | LAYER_HAZARD;
+
+    //overlapping bodies are pushed apart by this fraction of their overlap each step, doing it all at once makes piles jitter
+    float separation = 0.25f;
+
+    //sleeping. a body that's averaged less than sleepSpeed for sleepTime seconds is at rest, and once every body in its island is,
+    //the island goes to sleep: its bodies stop being integrated, swept and paired up, and they go into sleepTree instead.
+    //an awake body whose swept bounds reach a sleeping one wakes its whole island, and so does the level changing under it.
+    //so a step only costs what the awake bodies do. anything that changes a body from outside the step has to call WakeBody.
+    bool allowSleep = true;
+    float sleepSpeed = 4;
+    float sleepTime = 0.5f;
+    //how long each body has stayed near restAnchor. it's the distance moved that counts rather than the velocity,
+    //since a body in a stack has its velocity clipped (and nudged by the one unit buffer) every step and it jitters
+    //by tens of units a second while the body itself stays put.
+    std::vector<float> restTime;
+    std::vector<Vector2> restAnchor;
+    //the island each sleeping body is in and its leaf in sleepTree, -1 for awake bodies
+    std::vector<int> island;
+    std::vector<int> sleepProxy;
+    std::vector<BodyIsland> islands;
+    std::vector<int> freeIslands;
+    AABBTree sleepTree;
+    //the awake bodies other than the player, in index order. everything in StepBodies goes over this instead of all the bodies.
+    std::vector<int> active;
+    bool activeChanged = true;
+    //the level revision the sleeping islands were last checked against
+    unsigned int sleepRevision = 0;
+    //scratch for waking and for working out the islands: the sleeping bodies an awake one reaches,
+    //the union-find parents, and per island root the island it's going to sleep as and whether anything in it is still moving
+    std::vector<int> sleepFound;
+    std::vector<int> islandParent, newIsland;
+    std::vector<unsigned char> restless;
+
+    //for the debug text
+    int pairsTested = 0;
+    int contactsResolved = 0;
+    int sleepingIslands = 0;
+};
+
+#define BODY_BLOCKED_RIGHT 1
+#define BODY_BLOCKED_LEFT 2
+#define BODY_BLOCKED_DOWN 4
+#define BODY_BLOCKED_UP 8
+
+//adds a dynamic body at rest and returns its index in SimWorld::bodies
+int addBody(SimWorld& world, float x, float y, float w, float h, int type, float mass);
+
+//wakes the island the body is in, if it's asleep. call it after pushing a body or moving it from outside the step.
+void WakeBody(SimWorld& world, int body);
+
+//wakes everything and forgets the islands, for when the bodies are replaced
+void WakeAllBodies(SimWorld& world);
+
+//moves every dynamic body forward by dt
+void StepBodies(SimWorld& world, float dt);
+
+#endif
@@ -0,0 +1,96 @@
+#include "jobs.h"
+
+#include <algorithm>
+#include <chrono>
+
+//takes a job from the back of the thread's own queue, or failing that the front of another one
+static bool TakeJob(JobSystem& jobs, int self, std::function<void()>& job){
+    int queueCount = int(jobs.queues.size());
+    for(int k = 0; k < queueCount; k++){
+        int q = (self + k) % queueCount;
+        JobQueue& queue = *jobs.queues[q];
+        std::lock_guard<std::mutex> guard(queue.lock);
+        if(queue.jobs.empty()) continue;
+
+        if(k == 0){
+            job = std::move(queue.jobs.back());
+            queue.jobs.pop_back();
+        }
+        else{
+            job = std::move(queue.jobs.front());
+            queue.jobs.pop_front();
+        }
+        jobs.queued--;
+        return true;
+    }
+    return false;
+}
+
+static void WorkerLoop(JobSystem& jobs, int self){
+    std::function<void()> job;
+    while(!jobs.quit){
+        if(TakeJob(jobs, self, job)){
+            job();
+            continue;
+        }
+
+        //the timeout is only there in case a wake up is missed between checking and sleeping
+        std::unique_lock<std::mutex> sleep(jobs.sleepLock);
+        jobs.wake.wait_for(sleep, std::chrono::milliseconds(2), [&jobs]{ return jobs.queued > 0 || jobs.quit; });
+    }
+}
+
+void JobsInit(JobSystem& jobs, int workerCount){
+    JobsShutdown(jobs);
+    jobs.quit = false;
+    for(int i = 0; i <= workerCount; i++) jobs.queues.emplace_back(new JobQueue());
+    for(int i = 1; i <= workerCount; i++) jobs.workers.emplace_back(WorkerLoop, std::ref(jobs), i);
+}
+
+void JobsShutdown(JobSystem& jobs){
+    {
+        std::lock_guard<std::mutex> guard(jobs.sleepLock);
+        jobs.quit = true;
+    }
+    jobs.wake.notify_all();
+    for(auto& worker : jobs.workers) worker.join();
+    jobs.workers.clear();
+    jobs.queues.clear();
+    jobs.queued = 0;
+}
+
+JobSystem::~JobSystem(){
+    JobsShutdown(*this);
+}
+
+void ParallelFor(JobSystem* jobs, int count, int grain, const std::function<void(int chunk, int begin, int end)>& work){
+    int chunks = ParallelChunks(count, grain);
+    if(jobs == NULL || jobs->workers.empty() || chunks <= 1){
+        for(int c = 0; c < chunks; c++) work(c, c*grain, std::min(count, (c + 1)*grain));
+        return;
+    }
+
+    //the chunks are dealt out round robin so every queue starts with a share, stealing evens out the rest
+    std::atomic<int> remaining {chunks};
+    int queueCount = int(jobs->queues.size());
+    for(int c = 0; c < chunks; c++){
+        int begin = c*grain, end = std::min(count, (c + 1)*grain);
+        JobQueue& queue = *jobs->queues[c % queueCount];
+        std::lock_guard<std::mutex> guard(queue.lock);
+        queue.jobs.push_back([&work, &remaining, c, begin, end]{
+            work(c, begin, end);
+            remaining--;
+        });
+        jobs->queued++;
+    }
+    {
+        std::lock_guard<std::mutex> guard(jobs->sleepLock);
+    }
+    jobs->wake.notify_all();
+
+    std::function<void()> job;
+    while(remaining > 0){
+        if(TakeJob(*jobs, 0, job)) job();
+        else std::this_thread::yield();
+    }
+}
@@ -0,0 +1,50 @@
+#ifndef JOBS_H_
+#define JOBS_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//a small work stealing job system. every thread has its own queue: it takes work from the back of its own queue,
+//and when that runs dry it steals from the front of someone else's. the thread that starts a ParallelFor
+//works on it too instead of just waiting.
+struct JobQueue {
+    std::mutex lock;
+    std::deque<std::function<void()>> jobs;
+};
+
+struct JobSystem {
+    //queues[0] belongs to the thread that calls ParallelFor, queues[1..] to the workers
+    std::vector<std::unique_ptr<JobQueue>> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex sleepLock;
+    std::condition_variable wake;
+    std::atomic<int> queued {0};
+    std::atomic<bool> quit {false};
+
+    //stops the workers if JobsShutdown wasn't called
+    ~JobSystem();
+};
+
+//starts workerCount threads. with 0 everything just runs on the calling thread.
+void JobsInit(JobSystem& jobs, int workerCount);
+void JobsShutdown(JobSystem& jobs);
+
+inline int JobsThreadCount(const JobSystem& jobs){ return int(jobs.workers.size()) + 1; }
+
+//calls work(begin, end) over [0, count) in chunks of grain and returns once every chunk is done.
+//the chunks only depend on count and grain, never on how many threads there are, so anything that writes one
+//result per chunk and merges them in chunk order gets the same answer on any machine.
+//jobs can be NULL, which runs the whole range on the calling thread.
+void ParallelFor(JobSystem* jobs, int count, int grain, const std::function<void(int chunk, int begin, int end)>& work);
+
+//how many chunks ParallelFor will split count into
+inline int ParallelChunks(int count, int grain){ return count <= 0 ? 0 : (count + grain - 1) / grain; }
+
+#endif
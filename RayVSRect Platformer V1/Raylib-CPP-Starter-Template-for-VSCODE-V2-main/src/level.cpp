@@ -0,0 +1,316 @@
+#include "level.h"
+
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define LEVEL_USE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+using namespace std;
+
+void SetupDefaultLevel(SimWorld& world){
+    clearLevel(world);
+
+    // The player is the only moving rectangle, everything else is static level geometry.
+
+    world.bodies.push_back(movingRect {10.0f, 10.0f, 31.0f, 31.0f, 0, 2});
+    world.playerBody = 0;
+
+    addStatic(world, 100.0f, 650.0f, 50.0f, 50.0f, 2);
+    addStatic(world, 300.0f, 200.0f, 300.0f, 200.0f, 1);
+    addStatic(world, 610.0f, 200.0f, 10.0f, 10.0f, 1);
+    addStatic(world, 610.0f, 180.0f, 10.0f, 10.0f, 1);
+    addStatic(world, 610.0f, 160.0f, 10.0f, 10.0f, 1);
+    addStatic(world, 610.0f, 140.0f, 10.0f, 10.0f, 1);
+
+    addStatic(world, 120.0f, 700.0f, 80.0f, 50.0f, 1);
+    addStatic(world, 200.0f, 700.0f, 80.0f, 50.0f, 1);
+    addStatic(world, 280.0f, 700.0f, 80.0f, 50.0f, 1);
+    addStatic(world, 360.0f, 700.0f, 80.0f, 50.0f, 1);
+    addStatic(world, 440.0f, 700.0f, 80.0f, 50.0f, 1);
+    addStatic(world, 520.0f, 700.0f, 80.0f, 50.0f, 1);
+    addStatic(world, 600.0f, 700.0f, 80.0f, 50.0f, 1);
+    addStatic(world, 680.0f, 700.0f, 80.0f, 50.0f, 1);
+    addStatic(world, 760.0f, 700.0f, 80.0f, 50.0f, 1);
+    addStatic(world, 840.0f, 700.0f, 80.0f, 50.0f, 1);
+    addStatic(world, 840.0f, 650.0f, 80.0f, 50.0f, 1);
+    addStatic(world, 840.0f, 600.0f, 80.0f, 50.0f, 1);
+    addStatic(world, 840.0f, 550.0f, 80.0f, 50.0f, 1);
+    addStatic(world, 840.0f, 500.0f, 80.0f, 50.0f, 1);
+}
+
+//1 for every static that is one of the tile map's merged colliders, 0 for the rest
+static void tileFlags(const SimWorld& world, std::vector<unsigned char>& out){
+    out.resize(world.staticOwner.size());
+    for(size_t i = 0; i < out.size(); i++) out[i] = world.staticOwner[i] >= 0 ? 1 : 0;
+}
+
+//the whole file is formatted into one buffer and written with a single fwrite, instead of a flush per line.
+//%g writes numbers the way the old ofstream did, so files come out the same.
+static bool writeLevelText(const movingRect& player, const RectSoA& statics, const std::vector<unsigned char>& tiles, const char* fileName){
+    std::string text;
+    text.reserve(size_t(SoACount(statics) + 1)*32);
+    char line[160];
+    snprintf(line, sizeof(line), "%g,%g,%g,%g,%d\n", player.position.x, player.position.y, player.size.x, player.size.y, player.type);
+    text += line;
+    for(int i = 0; i < SoACount(statics); i++){
+        if(tiles[i]) snprintf(line, sizeof(line), "%g,%g,%g,%g,%d,1\n", statics.x[i], statics.y[i], statics.w[i], statics.h[i], int(statics.type[i]));
+        else snprintf(line, sizeof(line), "%g,%g,%g,%g,%d\n", statics.x[i], statics.y[i], statics.w[i], statics.h[i], int(statics.type[i]));
+        text += line;
+    }
+
+    FILE* file = fopen(fileName, "wb");
+    if(file == NULL) return false;
+    bool ok = fwrite(text.data(), 1, text.size(), file) == text.size();
+    return fclose(file) == 0 && ok;
+}
+
+bool saveLevel(const SimWorld& world, const char* fileName){
+    std::vector<unsigned char> tiles;
+    tileFlags(world, tiles);
+    return writeLevelText(SimPlayer(world), world.statics, tiles, fileName);
+}
+
+//reads the "x,y,width,height,type[,1]" lines out of text that's already in memory, and which statics were tiles into tiles.
+//positions are read as floats, so something like 680.052 survives a save and load.
+static void parseLevelText(SimWorld& world, const char* text, const char* textEnd, std::vector<unsigned char>& tiles){
+    clearLevel(world);
+    //zeroed, so a loaded player never starts with whatever velocity or force was left on the stack
+    movingRect RectIn {};
+
+    const char* line = text;
+    while(line < textEnd){
+        const char* lineEnd = (const char*)memchr(line, '\n', textEnd - line);
+        if(lineEnd == NULL) lineEnd = textEnd;
+
+        float values[6];
+        int found = 0;
+        const char* p = line;
+        while(found < 6 && p < lineEnd){
+            char* end;
+            values[found] = strtof(p, &end);
+            if(end == p || end > lineEnd) break;
+            found++;
+            p = end;
+            if(p < lineEnd && *p == ',') p++;
+        }
+        line = lineEnd + 1;
+
+        //blank or broken lines are skipped instead of throwing like std::stoi did
+        if(found < 5) continue;
+
+        RectIn.position = Vector2 {values[0], values[1]};
+        RectIn.size = Vector2 {values[2], values[3]};
+        RectIn.type = int(values[4]);
+
+        //the first line is always the player, the rest is level geometry
+        if(world.bodies.empty()) world.bodies.push_back(RectIn);
+        else {
+            SoAPush(world.statics, values[0], values[1], values[2], values[3], (unsigned char)RectIn.type);
+            tiles.push_back(found == 6 && values[5] != 0 ? 1 : 0);
+        }
+    }
+
+    rebuildLevelGrid(world);
+}
+
+//a view of a whole file in memory. on systems with mmap the file is mapped instead of read,
+//so nothing is copied until the level data goes into the world's arrays.
+struct LevelFileView {
+    const unsigned char* data = NULL;
+    size_t size = 0;
+    bool mapped = false;
+    std::vector<unsigned char> buffer;
+};
+
+static bool openLevelFile(LevelFileView& view, const char* fileName){
+#if defined(LEVEL_USE_MMAP)
+    int fd = open(fileName, O_RDONLY);
+    if(fd < 0) return false;
+
+    struct stat info;
+    if(fstat(fd, &info) != 0){
+        close(fd);
+        return false;
+    }
+
+    view.size = size_t(info.st_size);
+    if(view.size > 0){
+        void* mem = mmap(NULL, view.size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if(mem == MAP_FAILED) return false;
+        view.data = (const unsigned char*)mem;
+        view.mapped = true;
+    }
+    else close(fd);
+    return true;
+#else
+    FILE* file = fopen(fileName, "rb");
+    if(file == NULL) return false;
+
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if(length > 0){
+        view.buffer.resize(size_t(length));
+        view.size = fread(view.buffer.data(), 1, view.buffer.size(), file);
+        view.data = view.buffer.data();
+    }
+    fclose(file);
+    return true;
+#endif
+}
+
+static void closeLevelFile(LevelFileView& view){
+#if defined(LEVEL_USE_MMAP)
+    if(view.mapped) munmap((void*)view.data, view.size);
+#endif
+    view.data = NULL;
+    view.size = 0;
+    view.mapped = false;
+    view.buffer.clear();
+}
+
+static bool isBinaryLevel(const unsigned char* data, size_t size){
+    return size >= sizeof(LevelFileHeader) && memcmp(data, LEVEL_FILE_MAGIC, 4) == 0;
+}
+
+//tiles is pointed at the tile flags inside the data, or left NULL for a version 1 file that has none
+static bool parseLevelBinary(SimWorld& world, const unsigned char* data, size_t size, const unsigned char*& tiles){
+    LevelFileHeader header;
+    memcpy(&header, data, sizeof(header));
+    if(header.version != 1u && header.version != LEVEL_FILE_VERSION){
+        fprintf(stderr, "level file version %u is not supported\n", header.version);
+        return false;
+    }
+
+    size_t count = header.staticCount;
+    size_t bytesPerStatic = 4*sizeof(float) + (header.version == 1u ? 1 : 2);
+    if(size < sizeof(header) + count*bytesPerStatic){
+        fprintf(stderr, "level file is truncated\n");
+        return false;
+    }
+
+    clearLevel(world);
+
+    movingRect playerRect {};
+    playerRect.position = Vector2 {header.player[0], header.player[1]};
+    playerRect.size = Vector2 {header.player[2], header.player[3]};
+    playerRect.type = header.playerType;
+    world.bodies.push_back(playerRect);
+
+    //each array is one block copy straight out of the mapping
+    const float* arrays = (const float*)(data + sizeof(header));
+    RectSoA& statics = world.statics;
+    statics.x.assign(arrays, arrays + count);
+    statics.y.assign(arrays + count, arrays + 2*count);
+    statics.w.assign(arrays + 2*count, arrays + 3*count);
+    statics.h.assign(arrays + 3*count, arrays + 4*count);
+    const unsigned char* types = (const unsigned char*)(arrays + 4*count);
+    statics.type.assign(types, types + count);
+    if(header.version != 1u) tiles = types + count;
+
+    rebuildLevelGrid(world);
+    return true;
+}
+
+bool loadLevelMemory(SimWorld& world, const unsigned char* data, size_t size){
+    bool loaded = true;
+    const unsigned char* tiles = NULL;
+    std::vector<unsigned char> textTiles;
+    if(isBinaryLevel(data, size)) loaded = parseLevelBinary(world, data, size, tiles);
+    else {
+        parseLevelText(world, (const char*)data, (const char*)data + size, textTiles);
+        tiles = textTiles.data();
+    }
+
+    //painted tiles are saved as their merged rectangles with a flag, this hands them back to the tile map so they can be edited again
+    if(loaded && tiles != NULL) TilesAdoptStatics(world, tiles);
+    return loaded;
+}
+
+bool loadLevel(SimWorld& world, const char* fileName){
+    LevelFileView view;
+    if(!openLevelFile(view, fileName)){
+        fprintf(stderr, "could not open level %s\n", fileName);
+        return false;
+    }
+
+    bool loaded = loadLevelMemory(world, view.data, view.size);
+    closeLevelFile(view);
+    return loaded;
+}
+
+static LevelFileHeader makeLevelHeader(const movingRect& player, const RectSoA& statics){
+    LevelFileHeader header;
+    memcpy(header.magic, LEVEL_FILE_MAGIC, 4);
+    header.version = LEVEL_FILE_VERSION;
+    header.staticCount = unsigned(SoACount(statics));
+    header.playerType = player.type;
+    header.player[0] = player.position.x;
+    header.player[1] = player.position.y;
+    header.player[2] = player.size.x;
+    header.player[3] = player.size.y;
+    return header;
+}
+
+void encodeLevelBinary(const SimWorld& world, std::vector<unsigned char>& out){
+    const RectSoA& statics = world.statics;
+    LevelFileHeader header = makeLevelHeader(SimPlayer(world), statics);
+    size_t count = statics.x.size();
+
+    out.resize(sizeof(header) + count*(4*sizeof(float) + 2));
+    unsigned char* p = out.data();
+    memcpy(p, &header, sizeof(header));
+    p += sizeof(header);
+    const std::vector<float>* arrays[] = {&statics.x, &statics.y, &statics.w, &statics.h};
+    for(const std::vector<float>* array : arrays){
+        if(count > 0) memcpy(p, array->data(), count*sizeof(float));
+        p += count*sizeof(float);
+    }
+    if(count > 0) memcpy(p, statics.type.data(), count);
+    p += count;
+    for(size_t i = 0; i < count; i++) p[i] = world.staticOwner[i] >= 0 ? 1 : 0;
+}
+
+static bool writeLevelBinary(const movingRect& player, const RectSoA& statics, const std::vector<unsigned char>& tiles, const char* fileName){
+    LevelFileHeader header = makeLevelHeader(player, statics);
+
+    FILE* file = fopen(fileName, "wb");
+    if(file == NULL) return false;
+
+    size_t count = statics.x.size();
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    if(count > 0){
+        ok = ok && fwrite(statics.x.data(), sizeof(float), count, file) == count;
+        ok = ok && fwrite(statics.y.data(), sizeof(float), count, file) == count;
+        ok = ok && fwrite(statics.w.data(), sizeof(float), count, file) == count;
+        ok = ok && fwrite(statics.h.data(), sizeof(float), count, file) == count;
+        ok = ok && fwrite(statics.type.data(), 1, count, file) == count;
+        ok = ok && fwrite(tiles.data(), 1, count, file) == count;
+    }
+    return fclose(file) == 0 && ok;
+}
+
+bool saveLevelBinary(const SimWorld& world, const char* fileName){
+    std::vector<unsigned char> tiles;
+    tileFlags(world, tiles);
+    return writeLevelBinary(SimPlayer(world), world.statics, tiles, fileName);
+}
+
+void snapshotLevel(const SimWorld& world, LevelSnapshot& out){
+    out.player = SimPlayer(world);
+    out.statics = world.statics;
+    tileFlags(world, out.tiles);
+}
+
+bool saveLevelSnapshot(const LevelSnapshot& level, const char* fileName, bool binary){
+    if(binary) return writeLevelBinary(level.player, level.statics, level.tiles, fileName);
+    return writeLevelText(level.player, level.statics, level.tiles, fileName);
+}
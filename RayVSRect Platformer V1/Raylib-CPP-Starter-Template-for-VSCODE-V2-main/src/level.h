@@ -0,0 +1,53 @@
+#ifndef LEVEL_H_
+#define LEVEL_H_
+
+#include "sim.h"
+
+//fills the world with the hand placed test level, the player is always the first rectangle
+void SetupDefaultLevel(SimWorld& world);
+
+//text levels are stored as one "x,y,width,height,type" line per rectangle, starting with the player.
+//a static that is one of the tile map's merged colliders has ",1" on the end of its line.
+bool saveLevel(const SimWorld& world, const char* fileName);
+
+//binary levels (usually .rvl) hold the same data laid out the way SimWorld keeps it:
+//a LevelFileHeader, then every static's x, then every y, then w, then h as floats, then every type as one byte,
+//then one byte per static that is 1 if it's a tile collider. version 1 files stop after the types and have no tiles.
+//numbers are stored in the machine's byte order, little endian on everything we build for.
+#define LEVEL_FILE_MAGIC "RVRL"
+#define LEVEL_FILE_VERSION 2u
+
+struct LevelFileHeader {
+    char magic[4];
+    unsigned int version;
+    unsigned int staticCount;
+    int playerType;
+    float player[4];
+};
+
+bool saveLevelBinary(const SimWorld& world, const char* fileName);
+
+//loads either kind of level, binary files are recognised by their magic number. returns false if the file couldn't be read.
+//statics saved as tile colliders come back as tiles, everything else loads exactly as it was saved.
+bool loadLevel(SimWorld& world, const char* fileName);
+
+//the same for a level that's already in memory (either kind)
+bool loadLevelMemory(SimWorld& world, const unsigned char* data, size_t size);
+
+//just what a level file holds, copied out of a world so it can be written on another thread while the world carries on
+struct LevelSnapshot {
+    movingRect player;
+    RectSoA statics;
+    //1 for each static that is a tile collider
+    std::vector<unsigned char> tiles;
+};
+
+void snapshotLevel(const SimWorld& world, LevelSnapshot& out);
+
+//writes a snapshot as a binary level, or as a text one if binary is false
+bool saveLevelSnapshot(const LevelSnapshot& level, const char* fileName, bool binary);
+
+//the bytes saveLevelBinary would write, for storing a level inside another file
+void encodeLevelBinary(const SimWorld& world, std::vector<unsigned char>& out);
+
+#endif
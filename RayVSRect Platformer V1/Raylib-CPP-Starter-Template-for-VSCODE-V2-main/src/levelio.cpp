@@ -0,0 +1,110 @@
+#include "levelio.h"
+
+static void LevelIOWorker(LevelIO* io){
+    for(;;){
+        LevelIOJob job;
+        std::vector<std::unique_ptr<SimWorld>> retired;
+        {
+            std::unique_lock<std::mutex> guard(io->lock);
+            io->wake.wait(guard, [&]{ return io->quit || !io->queued.empty() || !io->retired.empty(); });
+            retired.swap(io->retired);
+            //quit only stops the worker once it has run dry
+            if(io->queued.empty()){
+                if(io->quit) return;
+                continue;
+            }
+            job = std::move(io->queued.front());
+            io->queued.pop_front();
+        }
+        retired.clear();
+
+        if(job.kind == LEVELIO_SAVE){
+            job.ok = saveLevelSnapshot(job.snapshot, job.fileName.c_str(), job.binary);
+            //the copy isn't needed any more, no point keeping it around until the main thread looks
+            job.snapshot.statics = RectSoA();
+            job.snapshot.tiles = std::vector<unsigned char>();
+        }
+        else job.ok = loadLevel(*job.loaded, job.fileName.c_str()) && !job.loaded->bodies.empty();
+
+        std::lock_guard<std::mutex> guard(io->lock);
+        io->finished.push_back(std::move(job));
+    }
+}
+
+static void LevelIOQueue(LevelIO& io, LevelIOJob&& job){
+    {
+        std::lock_guard<std::mutex> guard(io.lock);
+        io.queued.push_back(std::move(job));
+    }
+    if(!io.worker.joinable()) io.worker = std::thread(LevelIOWorker, &io);
+    io.busy++;
+    io.wake.notify_one();
+}
+
+void LevelSaveAsync(LevelIO& io, const SimWorld& world, const char* fileName, bool binary){
+    LevelIOJob job;
+    job.kind = LEVELIO_SAVE;
+    job.fileName = fileName;
+    job.binary = binary;
+    job.ok = false;
+    //a few block copies, this is all the save costs the frame it was asked for in
+    snapshotLevel(world, job.snapshot);
+    LevelIOQueue(io, std::move(job));
+}
+
+void LevelLoadAsync(LevelIO& io, const SimWorld& world, const char* fileName){
+    LevelIOJob job;
+    job.kind = LEVELIO_LOAD;
+    job.fileName = fileName;
+    job.binary = false;
+    job.ok = false;
+    job.loaded.reset(new SimWorld());
+    //the grid and tree are built for the live world's settings, since they get swapped in along with the level
+    job.loaded->tileSize = world.tileSize;
+    job.loaded->treeMinSize = world.treeMinSize;
+    LevelIOQueue(io, std::move(job));
+}
+
+int LevelIOUpdate(LevelIO& io, SimWorld& world, LevelIOResult* out, int maxResults){
+    int results = 0;
+    while(results < maxResults){
+        LevelIOJob job;
+        {
+            std::lock_guard<std::mutex> guard(io.lock);
+            if(io.finished.empty()) break;
+            job = std::move(io.finished.front());
+            io.finished.pop_front();
+        }
+        io.busy--;
+
+        if(job.kind == LEVELIO_LOAD){
+            if(job.ok) swapLevel(world, *job.loaded);
+            {
+                std::lock_guard<std::mutex> guard(io.lock);
+                io.retired.push_back(std::move(job.loaded));
+            }
+            io.wake.notify_one();
+        }
+        out[results++] = LevelIOResult {job.kind, job.ok, job.fileName};
+    }
+    return results;
+}
+
+void LevelIOShutdown(LevelIO& io){
+    if(io.worker.joinable()){
+        {
+            std::lock_guard<std::mutex> guard(io.lock);
+            io.quit = true;
+        }
+        io.wake.notify_all();
+        io.worker.join();
+    }
+    io.quit = false;
+    io.finished.clear();
+    io.retired.clear();
+    io.busy = 0;
+}
+
+LevelIO::~LevelIO(){
+    LevelIOShutdown(*this);
+}
@@ -0,0 +1,67 @@
+#ifndef LEVELIO_H_
+#define LEVELIO_H_
+
+//saving and loading levels on a background thread, so a big level doesn't stall the frame it was asked for in.
+//a save copies the level out of the world straight away (see LevelSnapshot) and formats and writes the copy on the worker.
+//a load reads and parses into a world of its own on the worker, tile merging and grid building included,
+//and LevelIOUpdate swaps it into the live world between frames. jobs run one at a time in the order they were asked for,
+//so a load queued after a save of the same file sees what was saved.
+
+#include "sim.h"
+#include "level.h"
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum LevelIOKind { LEVELIO_SAVE, LEVELIO_LOAD };
+
+struct LevelIOJob {
+    LevelIOKind kind;
+    std::string fileName;
+    bool binary;
+    bool ok;
+    //saves: the level as it was when the save was asked for. loads: the world the file is loaded into.
+    LevelSnapshot snapshot;
+    std::unique_ptr<SimWorld> loaded;
+};
+
+struct LevelIO {
+    std::thread worker;
+    std::mutex lock;
+    std::condition_variable wake;
+    std::deque<LevelIOJob> queued;
+    std::deque<LevelIOJob> finished;
+    //levels a load replaced. freeing a big one (its grid cells and tree nodes) takes long enough to notice, so the worker does it.
+    std::vector<std::unique_ptr<SimWorld>> retired;
+    int busy = 0;       //jobs asked for that LevelIOUpdate hasn't handed back yet
+    bool quit = false;
+
+    //waits for anything still queued (so a save isn't lost) and stops the worker
+    ~LevelIO();
+};
+
+//what LevelIOUpdate did with a finished job
+struct LevelIOResult {
+    LevelIOKind kind;
+    bool ok;
+    std::string fileName;
+};
+
+//the worker is started by the first request
+void LevelSaveAsync(LevelIO& io, const SimWorld& world, const char* fileName, bool binary);
+void LevelLoadAsync(LevelIO& io, const SimWorld& world, const char* fileName);
+
+//call once a frame, outside of stepping. swaps in a finished load (a failed one leaves the world alone)
+//and reports every job that finished, oldest first. returns how many results it wrote to out.
+int LevelIOUpdate(LevelIO& io, SimWorld& world, LevelIOResult* out, int maxResults);
+
+inline bool LevelIOBusy(const LevelIO& io){ return io.busy > 0; }
+
+//finishes everything that's queued, then stops the worker. finished loads are dropped.
+void LevelIOShutdown(LevelIO& io);
+
+#endif
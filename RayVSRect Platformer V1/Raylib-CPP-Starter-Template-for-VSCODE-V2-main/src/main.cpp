@@ -1,11 +1,22 @@
 #include <raylib.h>
 #include <raymath.h>
 #include <math.h>
+#include <string.h>
 #include <algorithm>
 #include <iostream>
 #include <vector>
-#include <fstream>
 #include "animation.h"
+#include "atlas.h"
+#include "sim.h"
+#include "level.h"
+#include "render.h"
+#include "jobs.h"
+#include "query.h"
+#include "profile.h"
+#include "replay.h"
+#include "stream.h"
+#include "levelio.h"
+#include <thread>
 using namespace std;
 
 Camera2D originCam;
@@ -14,207 +25,76 @@ Camera2D playerCam;
 //Sprite stuff
     Texture2D playerSprite;
 
-// a raycasting function returns a ray. a ray's attributes are:
-//if it has intersected with a rectangle or not, (collided)
-//the coordinates where it intersects the rectangle, the direction of the x and y normals from the collision, (contact_point, contact_normal)
-//and the ratio of the shortest ray it would take to collide with the rectangle given its current direction to the ray's actual length. (rayCheck)
-//if rayCheck is below 1 AND collided is true, a collision has occured.
-
-struct ray {
-    bool collided;
-    Vector2 contact_point, contact_normal;
-    float rayCheck;
-    int type = 1;
-};
-
-struct collision {
-    int first;
-    float second;
-    int third;
-};
-//a collision function should return zeroRay when it knows a collision will not take place given the input parameters
-ray zeroRay = {0, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
-
-struct movingRect{
-    Vector2 position;
-    Vector2 size;
-    int type = 1;
-    float mass = 1;
-    Vector2 velocity;
-    Vector2 acc;
-    Vector2 force;
-    
-};
-
-
-/*std::vector<std::pair<bool*, float>> vTimers;
-void timer(bool inputBool, float timeWindow, float timerVar = GetTime()){
-    timerVar = GetTime();
-    vTimers.push_back({&inputBool, float(timerVar + timeWindow)});
-}
-*/
-
-float sign(float in){
-    if(in < 0) return -1;
-    if(in > 0) return 1;
-    if(in == 0) return 0;
-}
-
-
-//returns a ray struct after being given an origin, direction, and a rectangle to collide with.
-ray RayVsRect(const Vector2& ray_origin, const Vector2& ray_dir, movingRect r){
-
-Vector2 t_near = Vector2Divide((Vector2Subtract(r.position, ray_origin)), ray_dir);
-Vector2 t_far =  Vector2Divide(Vector2Add(r.position, Vector2Subtract(r.size, ray_origin)), ray_dir);
+//B draws the bodies as animated doges and the player as the seal, all through one SpriteBatch
+bool spritesEnabled = false;
+FramePool framePool;
+//every sprite packed into one texture by "make atlas", without it the sprites are loaded one file at a time
+SpriteAtlas spriteAtlas;
+Texture2D dogeAtlas;
+SpriteAnimation dogeAnimation, sealAnimation;
+std::vector<SpritePlayback> bodyPlayback;
+SpriteBatch spriteBatch;
 
-if(std::isnan(t_far.y) || std::isnan(t_far.x)) return zeroRay;
-if(std::isnan(t_near.y) || std::isnan(t_near.x)) return zeroRay;
+//the physics, the level and the player's movement state all live in the world, see sim.h
+SimWorld world;
+#define player SimPlayer(world)
 
-if(t_near.x > t_far.x) std::swap(t_near.x, t_far.x);
-if(t_near.y > t_far.y) std::swap(t_near.y, t_far.y);
+//worker threads for stepping the bodies, one for every core the main thread isn't using
+JobSystem jobs;
 
-if(t_near.x > t_far.y || t_near.y > t_far.x) return zeroRay;
+//steps the world at a fixed rate (120 steps a second unless stepDt is changed) however fast the game is drawing
+SimClock simClock;
 
-float t_hit_near = std::max(t_near.x, t_near.y);
-float t_hit_far = std::min(t_far.x, t_far.y);
+//F5 restarts the session from the current level and records it, F5 again saves it to replay.rvr.
+//"headless --replay replay.rvr" plays it back exactly and times every frame.
+Replay replay;
 
-if (t_hit_far < 0) return zeroRay;
+//only used when the game is started with a streamed level, "game level.rvs"
+LevelStream levelStream;
+const char* replayStatus = "";
 
-Vector2 contact_point = Vector2 {std::round(Vector2Add(ray_origin, Vector2Multiply(Vector2 {t_hit_near, t_hit_near}, ray_dir)).x), std::round(Vector2Add(ray_origin, Vector2Multiply(Vector2 {t_hit_near, t_hit_near}, ray_dir)).y)}; 
-Vector2 contact_normal = {0, 0};
-
-if(t_near.x > t_near.y){
-    if(ray_dir.x < 0) contact_normal = {1, 0};
-    else contact_normal = {-1, 0};
-}
-else if (t_near.x < t_near.y){
-    if (ray_dir.y < 0) contact_normal = {0, 1};
-    else contact_normal = {0, -1};
-}
-//debug raycasting info
-//DrawText(TextFormat("tHitNear = %f x = %f y = %f, \n \n normX = %f, normY = %f \n\n type = %i", t_hit_near, contact_point.x, contact_point.y, contact_normal.x, contact_normal.y, r.type), 0, 0, 32, WHITE);
-return ray {1, contact_point, contact_normal, t_hit_near, r.type};
-}
-
-//returns a ray struct when given two rectangles, the "in" rectangle should be considered the moving one, and the "target" rectangle should be static (not moving).
-//The DynamicRectVSRect function calls the rayVsRect function. The ray's origin is the 'in' rectangle's center coordinates, and the ray direction is the 'in' rectangle's velocity modulated by deltaTime.
-//The single rectangle input for RayVsRect should be the 'target' rectangle expanded by half the width and height of the 'in' rectangle.
-ray DynamicRectVSRect(const movingRect& in, const movingRect& target){
-    if(in.velocity.x == 0 && in.velocity.y == 0) return zeroRay;
-
-    movingRect expanded_target;
-    expanded_target.position.x = target.position.x - in.size.x/2;
-    expanded_target.position.y = target.position.y - in.size.y/2;
-    expanded_target.size.x = target.size.x + in.size.x;
-    expanded_target.size.y = target.size.y + in.size.y;
-    
-    Vector2 inCenter = {in.position.x + in.size.x/2, in.position.y + in.size.y/2};
-
-    ray RectRay = RayVsRect(inCenter, Vector2{in.velocity.x*GetFrameTime(), in.velocity.y*GetFrameTime()}, expanded_target);
-    RectRay.type = target.type;
-    if(RectRay.collided && RectRay.rayCheck <= 1.0f) {
-        return RectRay;
-    }
-    else return zeroRay;
-    }
-
-//this vector stores each rectangle for easy drawing and collision detection purposes
-std::vector<movingRect> vRects;
-std::vector<movingRect> vSpikes;
-#define player vRects[0]
-
-void applyForce(float fx, float fy){
-
-player.force = Vector2Add(player.force, Vector2 {fx, fy});
-
-}
+//Ctrl+S and Ctrl+O save and load on a background thread, a loaded level is swapped in at the start of a frame
+LevelIO levelIO;
+const char* levelIOStatus = "";
 
 void SetupGame(){
 
 
-    playerSprite = LoadTexture("textures/SealPlayer.png");
-
-    // First rectangle in this list is always the 'player rectangle'
-    // and is always controlled by the mouse.
-
-    vRects.push_back(movingRect {10.0f, 10.0f, 31.0f, 31.0f, 0, 2});
-
-    vRects.push_back(movingRect {100.0f, 650.0f, 50.0f, 50.0f, 2, 1});
-    vRects.push_back(movingRect {300.0f, 200.0f, 300.0f, 200.0f});
-    vRects.push_back(movingRect {610.0f, 200.0f, 10.0f, 10.0f});
-    vRects.push_back(movingRect {610.0f, 180.0f, 10.0f, 10.0f});
-    vRects.push_back(movingRect {610.0f, 160.0f, 10.0f, 10.0f});
-    vRects.push_back(movingRect {610.0f, 140.0f, 10.0f, 10.0f});
-
-    vRects.push_back(movingRect {120.0f, 700.0f, 80.0f, 50.0f});
-    vRects.push_back(movingRect {200.0f, 700.0f, 80.0f, 50.0f});
-    vRects.push_back(movingRect {280.0f, 700.0f, 80.0f, 50.0f});
-    vRects.push_back(movingRect {360.0f, 700.0f, 80.0f, 50.0f});
-    vRects.push_back(movingRect {440.0f, 700.0f, 80.0f, 50.0f});
-    vRects.push_back(movingRect {520.0f, 700.0f, 80.0f, 50.0f});
-    vRects.push_back(movingRect {600.0f, 700.0f, 80.0f, 50.0f});
-    vRects.push_back(movingRect {680.0f, 700.0f, 80.0f, 50.0f});
-    vRects.push_back(movingRect {760.0f, 700.0f, 80.0f, 50.0f});
-    vRects.push_back(movingRect {840.0f, 700.0f, 80.0f, 50.0f});
-    vRects.push_back(movingRect {840.0f, 650.0f, 80.0f, 50.0f});
-    vRects.push_back(movingRect {840.0f, 600.0f, 80.0f, 50.0f});
-    vRects.push_back(movingRect {840.0f, 550.0f, 80.0f, 50.0f});
-    vRects.push_back(movingRect {840.0f, 500.0f, 80.0f, 50.0f});
-
-}
-
-void saveLevel(){
-        ofstream inLevel;
-    inLevel.open("LevelOne.txt");
-
-    if(inLevel.is_open()){
-    for(int i = 0; i < vRects.size(); i++){
-        
-    inLevel << vRects[i].position.x  << "," << vRects[i].position.y << "," << vRects[i].size.x << "," << vRects[i].size.y << "," << vRects[i].type << endl;
-    
-    }
-}
-    inLevel.close();
-}
-
-void loadLevel(){
-    std::ifstream myfile("LevelOne.txt");
-    std::string RectangleData;
-    vRects.clear();
-    movingRect RectIn;
-    while(getline(myfile, RectangleData)){
-        int firstpos = 0;
-        int commaPos[5] = {0};
-        std::string RectString[5];
-    for(int i = 1; i < 5; i++){
-    firstpos = RectangleData.find(",", std::size_t(firstpos + 1));
-    commaPos[i] = firstpos;
-    
-    }
-
-    RectString[0] = RectangleData.substr(0, commaPos[1]);
-
-    for(int i = 1; i < 5; i++){
-        RectString[i] = RectangleData.substr(commaPos[i] + 1, commaPos[i+1] - commaPos[i] - 1);
+    if(LoadSpriteAtlas(spriteAtlas, "textures/atlas.txt")){
+        dogeAnimation = CreateAtlasAnimation(framePool, spriteAtlas, "DogePlayer", 6);
+        sealAnimation = CreateAtlasAnimation(framePool, spriteAtlas, "SealPlayer", 1);
+        playerSprite = sealAnimation.atlas;
     }
+    else{
+        playerSprite = LoadTexture("textures/SealPlayer.png");
+
+        //the three doge frames are separate files, so they're put side by side in one texture for the batch
+        Image dogeImage = GenImageColor(240, 80, BLANK);
+        const char* dogeFrames[] = {"textures/DogePlayer1.png", "textures/DogePlayer2.png", "textures/DogePlayer3.png"};
+        Rectangle dogeRects[3];
+        for(int i = 0; i < 3; i++){
+            Image frame = LoadImage(dogeFrames[i]);
+            dogeRects[i] = Rectangle {80.0f*i, 0, 80, 80};
+            ImageDraw(&dogeImage, frame, Rectangle {0, 0, float(frame.width), float(frame.height)}, dogeRects[i], WHITE);
+            UnloadImage(frame);
+        }
+        dogeAtlas = LoadTextureFromImage(dogeImage);
+        UnloadImage(dogeImage);
+        dogeAnimation = CreateSpriteAnimation(framePool, dogeAtlas, 6, dogeRects, 3);
 
-    cout << commaPos[0] << "," << commaPos[1] << "," << commaPos[2] << "," << commaPos[3] << "{";
-    
-    for(int i = 0; i < 5; i++){
-        cout << RectString[i] << "|";
-    }
-    cout << "\n";
-    RectIn.position.x = std::stoi(RectString[0]);
-    RectIn.position.y = std::stoi(RectString[1]);
-    RectIn.size.x = std::stoi(RectString[2]);
-    RectIn.size.y = std::stoi(RectString[3]);
-    RectIn.type = std::stoi(RectString[4]);
-    vRects.push_back(RectIn);
+        Rectangle sealRect = {0, 0, 26, 19};
+        sealAnimation = CreateSpriteAnimation(framePool, playerSprite, 1, &sealRect, 1);
     }
 
+    SetupDefaultLevel(world);
 
+    JobsInit(jobs, std::max(0, int(std::thread::hardware_concurrency()) - 1));
+    world.jobs = &jobs;
 }
 
+//draws the level, culled to the camera and with the static geometry cached in render textures
+LevelRenderer levelRenderer;
+
 //camera movement variables
 int cameraMode = 1;
 Camera2D currentCam = originCam;
@@ -222,8 +102,7 @@ float originZoom = 1.0f;
 Vector2 originTarget;
 void MoveCamera()
 {
-
-DrawText(TextFormat("target.x = %f, target.y = %f, camMode = %i", currentCam.target.x, currentCam.target.y, cameraMode ), 100, 300, 20, WHITE);
+PROFILE_SCOPE("MoveCamera");
 
 if(cameraMode == 0){
 currentCam = originCam;
@@ -246,150 +125,69 @@ else if(cameraMode == 1){
     playerCam.offset = Vector2 {float(GetScreenWidth())/2, float(GetScreenHeight())/2};
     playerCam.zoom = 1.0f;
     playerCam.rotation = 0.0f;
-    playerCam.target = Vector2 {player.position.x - player.velocity.x*GetFrameTime(), player.position.y - player.velocity.y*GetFrameTime()};
+    Vector2 playerDrawn = InterpolatedPosition(world, simClock, world.playerBody);
+    playerCam.target = Vector2 {playerDrawn.x - player.velocity.x*GetFrameTime(), playerDrawn.y - player.velocity.y*GetFrameTime()};
 }
 
 
+    PrepareLevelRender(levelRenderer, world, currentCam);
     BeginMode2D(currentCam);
 
 }
 
 
-//game variables
+//level editor variables
 KeyboardKey KEY_JUMP;
-Vector2 playerSpawn = Vector2 {100, 100};
-float gravity = 1500;
-float gravityModifier = 1;
-float playerHeight = 31;
-float crouchHeight = 23;
-float playerSpeed = 300;
-float slideSpeed = 750;
-float accConstant = 30;
-float brakingConstant = 30;
-float walkingVel = 0;
-float groundedCoyoteTimer;
-float wallslideLeftCoyoteTimer, wallslideRightCoyoteTimer;
-float groundedCoyoteWindow = 0.1;
-float wallslideCoyoteWindow = 0.2;
-bool crouching = 0;
-bool sliding = 0;
-
-
 Vector2 RectangleOrigin;
 bool drawingRectangle = false;
-float tileSize = 16.0f;
-const int worldWidth = 200;
-const int worldHeight = 200;
-int worldArray[worldWidth][worldHeight] = {0}; 
 int RectangleType = 1;
-float bufferJumpTimer, noControlTimer;
-float bufferWindow = 0.1;
-float noControlWindow = 0.20;
-bool controlsEnabled = 1;
-bool grounded, jumping, wallslidingRight, wallslidingLeft;
-float jumpVel = 600;
-float wallJumpVel = 420;
-float pushoffVel = 400;
-
-void playerDeath() {
-player.position = playerSpawn;
-player.velocity = Vector2{0,0};
-}
 
-void playerJump() {
+//the controls for the next simulation step, filled in by GetInput()
+SimInput simInput;
 
-//debug info
-    if(KEY_JUMP == KEY_W){
-       DrawText(TextFormat("BJT: %f, Time: %f, KEYJUMP: W", bufferJumpTimer, GetTime()), 100, 100, 20, YELLOW); 
-    }
-    if(KEY_JUMP == KEY_SPACE){
-       DrawText(TextFormat("BJT: %f, Time: %f, KEYJUMP: SPACE", bufferJumpTimer, GetTime()), 100, 100, 20, YELLOW); 
-    }
-
-
-
-//walljump logic
-    if(!grounded)
-    {
-        if(wallslidingRight || GetTime() < wallslideRightCoyoteTimer)
-        {
-        controlsEnabled = 0;
-        player.velocity.y = -wallJumpVel;
-        player.velocity.x = -pushoffVel;
-        noControlTimer = GetTime();
-        jumping = 1;
-        wallslidingRight = 0;
-        wallslideRightCoyoteTimer = 0;
-        }
+bool gridEnabled = 0;
 
-        else if (wallslidingLeft || GetTime() < wallslideLeftCoyoteTimer)
-        {
-        controlsEnabled = 0;
-        player.velocity.y = -wallJumpVel;
-        player.velocity.x = pushoffVel;
-        noControlTimer = GetTime();
-        jumping = 1;
-        wallslidingLeft = 0;
-        wallslideLeftCoyoteTimer = 0;
-        }
+void GetInput() {
+PROFILE_SCOPE("GetInput");
 
-    else{
-    bufferJumpTimer = GetTime();
-        }
+if(IsKeyPressed(KEY_F5)){
+    if(replay.recording){
+        replayStatus = ReplayEnd(replay, world, "replay.rvr") ? "saved replay.rvr" : "couldn't save replay.rvr";
     }
-
-
-
-    if((grounded) || GetTime() < groundedCoyoteTimer ){
-
-        if(sliding){
-            brakingConstant = 0;
-            player.velocity.x = sign(player.velocity.x) * 600;
-            player.velocity.y = -jumpVel;
-            grounded = 0;
-            jumping = 1;
-        }
-
-        else{
-    player.velocity.y = -jumpVel;
-    grounded = 0;
-    jumping = 1;
-        }
+    else{
+        ReplayBegin(replay, world, simClock);
+        replayStatus = "recording";
     }
-
-
-
 }
 
 
-bool gridEnabled = 0;
-
-void GetInput() {
-
-player.force = Vector2 {0, 0};
-
-
 if(IsKeyDown(KEY_LEFT_CONTROL)){
     if(IsKeyPressed(KEY_S)){
-    saveLevel();
+    LevelSaveAsync(levelIO, world, "LevelOne.txt", false);
+    levelIOStatus = "saving LevelOne.txt";
     }
     else if(IsKeyPressed(KEY_O)){
-        loadLevel();
+        LevelLoadAsync(levelIO, world, "LevelOne.txt");
+        levelIOStatus = "loading LevelOne.txt";
     }
     else if(IsKeyPressed(KEY_Z)){
-        vRects.erase(vRects.end());
+        removeStatic(world, SoACount(world.statics) - 1);
     }
 }
 
+//drops a block of 1000 dynamic bodies at the mouse
 if(IsKeyPressed(KEY_M)){
+    Vector2 mouseWorld = GetScreenToWorld2D(GetMousePosition(), currentCam);
     for(int i = 0; i < 1000; i++){
-        vRects.push_back(movingRect {10, 10, 10, 10, 2});
+        addBody(world, mouseWorld.x + (i % 40)*12, mouseWorld.y + (i / 40)*12, 10, 10, 1, 1);
     }
 }
 
 if(IsKeyPressed(KEY_G) && gridEnabled == 1) gridEnabled = 0;
 else if(IsKeyPressed(KEY_G) && gridEnabled == 0) gridEnabled = 1;
 
+if(IsKeyPressed(KEY_B)) spritesEnabled = !spritesEnabled;
+
 if(IsKeyPressed(KEY_ONE)) RectangleType = 1;
 else if(IsKeyPressed(KEY_TWO)) RectangleType = 2;
 
@@ -406,21 +204,21 @@ if(IsMouseButtonPressed(MOUSE_BUTTON_RIGHT)){
     if(RectangleOrigin.x > RectangleSecondary.x)
     {
         if(RectangleOrigin.y > RectangleSecondary.y){
-           vRects.push_back(movingRect {RectangleSecondary.x, RectangleSecondary.y, RectangleOrigin.x - RectangleSecondary.x, RectangleOrigin.y - RectangleSecondary.y, RectangleType});
+           addStatic(world, RectangleSecondary.x, RectangleSecondary.y, RectangleOrigin.x - RectangleSecondary.x, RectangleOrigin.y - RectangleSecondary.y, RectangleType);
         }
         else
         {
-            vRects.push_back(movingRect {RectangleSecondary.x, RectangleOrigin.y, RectangleOrigin.x - RectangleSecondary.x, RectangleSecondary.y-RectangleOrigin.y, RectangleType});
+            addStatic(world, RectangleSecondary.x, RectangleOrigin.y, RectangleOrigin.x - RectangleSecondary.x, RectangleSecondary.y-RectangleOrigin.y, RectangleType);
         }
     }
       if(RectangleOrigin.x <= RectangleSecondary.x)
     {
         if(RectangleOrigin.y > RectangleSecondary.y){
-            vRects.push_back(movingRect {RectangleOrigin.x, RectangleSecondary.y, RectangleSecondary.x - RectangleOrigin.x, RectangleOrigin.y - RectangleSecondary.y, RectangleType});
+            addStatic(world, RectangleOrigin.x, RectangleSecondary.y, RectangleSecondary.x - RectangleOrigin.x, RectangleOrigin.y - RectangleSecondary.y, RectangleType);
         }
         else
         {
-            vRects.push_back(movingRect {RectangleOrigin.x, RectangleOrigin.y, RectangleSecondary.x - RectangleOrigin.x, RectangleSecondary.y-RectangleOrigin.y, RectangleType});
+            addStatic(world, RectangleOrigin.x, RectangleOrigin.y, RectangleSecondary.x - RectangleOrigin.x, RectangleSecondary.y-RectangleOrigin.y, RectangleType);
         }
     }
     drawingRectangle = false;
@@ -434,34 +232,23 @@ if(IsMouseButtonPressed(MOUSE_BUTTON_RIGHT)){
 }
 }
 
+//grid painting goes into the tile layer, which merges the tiles into bigger colliders. shift erases.
 if(gridEnabled){
 if(IsMouseButtonDown(MOUSE_BUTTON_RIGHT)){
-    DrawText(TextFormat("vRects.size() = %i", vRects.size()), 100, 500, 20, WHITE);
-    movingRect newRect = movingRect {tileSize*(int(((GetScreenToWorld2D(GetMousePosition(), currentCam)).x)/tileSize)), tileSize*(int(((GetScreenToWorld2D(GetMousePosition(), currentCam)).y)/tileSize)), tileSize, tileSize, RectangleType};
-    for(int i = 1; i < int(vRects.size()); i++){
-        if(Vector2Equals(newRect.size, vRects[i].size) && Vector2Equals(newRect.position, vRects[i].position)){
-            vRects.erase(vRects.begin()+i);
-        }
-
-    }
-
-    vRects.push_back(newRect);
+    DrawText(TextFormat("statics = %i", SoACount(world.statics)), 100, 500, 20, WHITE);
+    Vector2 mouseWorld = GetScreenToWorld2D(GetMousePosition(), currentCam);
+    int paintType = IsKeyDown(KEY_LEFT_SHIFT) ? 0 : RectangleType;
+    SetTile(world, TileCell(world, mouseWorld.x), TileCell(world, mouseWorld.y), paintType);
 }
 }
 
 
-if(GetTime() <= noControlTimer + noControlWindow && GetTime() >= noControlTimer){
-    controlsEnabled = 0;
-}
-else{
-    controlsEnabled = 1;    
-}
+simInput = SimInput {};
 
-if(controlsEnabled){
+if(world.controlsEnabled){
+
+simInput.respawn = IsKeyPressed(KEY_R);
 
-if(IsKeyPressed(KEY_R)){
-    playerDeath();
-}
 //camera controls
 if(IsKeyPressed(KEY_C)){
     if(cameraMode == 0){
@@ -472,312 +259,168 @@ if(IsKeyPressed(KEY_C)){
         }
 }
 
+}
 
-    
-
-
-
-//JUMP LOGIC
 if(IsKeyPressed(KEY_W)){
     KEY_JUMP = KEY_W;
-    playerJump();
-    
+    simInput.jumpPressed = true;
 }
 
 if(IsKeyPressed(KEY_SPACE)){
     KEY_JUMP = KEY_SPACE;
-    playerJump();
-    
+    simInput.jumpPressed = true;
 }
 
-if((grounded || wallslidingLeft || wallslidingRight) && GetTime() <= bufferJumpTimer + bufferWindow && GetTime() >= bufferJumpTimer){
-playerJump();
-bufferJumpTimer = 0;
-}
-
-//if(jumping){
-
-    if(IsKeyUp(KEY_JUMP) && jumping){
-       //if player is moving up, double the force of gravity until they're not moving up, then apply normal gravity
-        if(player.velocity.y < 0){
-        gravityModifier = 2.0;
-        }       
+simInput.jumpHeld = !IsKeyUp(KEY_JUMP);
+simInput.left = IsKeyDown(KEY_A);
+simInput.right = IsKeyDown(KEY_D);
+simInput.leftPressed = IsKeyPressed(KEY_A);
+simInput.rightPressed = IsKeyPressed(KEY_D);
+simInput.crouch = IsKeyDown(KEY_S);
+simInput.crouchPressed = IsKeyPressed(KEY_S);
 
-    }
-else {
-    gravityModifier = 1;
-}
-    if(player.velocity.y >= 0){
-            gravityModifier = 1;
-        }
-
-    if(grounded){
-        jumping = false;
-        gravityModifier = 1;
-        }
-//END JUMP LOGIC
-
-//movement logic
-float targetSpeed = 0;
+                    }
 
 
-if(!crouching){
-if(IsKeyDown(KEY_A)){
-    targetSpeed = -playerSpeed;
-    float speedDif = player.velocity.x - targetSpeed;
-    float movement = -(speedDif*accConstant);
-    applyForce(movement, 0);
-}
-else if (IsKeyDown(KEY_D)){
-    targetSpeed = playerSpeed;
-    float speedDif = player.velocity.x - targetSpeed;
-    float movement = -speedDif*accConstant;
-    applyForce(movement, 0);
-}
-else{
-    targetSpeed = 0;
-    float speedDif = -player.velocity.x;
-    float movement = speedDif*brakingConstant;
-    applyForce(movement, 0);
-}
-}
+void RunLogic() {
+PROFILE_SCOPE("RunLogic");
 
-//crouched movement logic
-else if(crouching && grounded){
-    if(IsKeyPressed(KEY_A))
-{
-    player.velocity.x += -slideSpeed;
-    sliding = 1; 
-}
-else if (IsKeyPressed(KEY_D))
-{
-    player.velocity.x += slideSpeed;
-    sliding = 1;
-}
-else
-{
-    targetSpeed = 0;
-    float speedDif = -player.velocity.x;
-    float movement = speedDif*brakingConstant/3;
-    applyForce(movement, 0);
+float frameTime = GetFrameTime();
+if(replay.recording && !ReplayRecordFrame(replay, world, simInput, frameTime)){
+    replayStatus = "recording stopped, the level was edited";
 }
+LevelIOResult results[8];
+int finished = LevelIOUpdate(levelIO, world, results, 8);
+for(int i = 0; i < finished; i++){
+    if(results[i].kind == LEVELIO_LOAD){
+        levelIOStatus = results[i].ok ? "loaded LevelOne.txt" : "couldn't load LevelOne.txt";
+        //the loaded level replaced the streamed one
+        if(results[i].ok) StreamClose(levelStream);
     }
-
-    
+    else levelIOStatus = results[i].ok ? "saved LevelOne.txt" : "couldn't save LevelOne.txt";
 }
 
-if(IsKeyPressed(KEY_S) && grounded){
-    player.position.y += (player.size.y - crouchHeight);
-    player.size.y = crouchHeight;
-}
-if(IsKeyDown(KEY_S)){
+//streaming goes before the step so the chunks the player is about to reach are already in
+StreamUpdate(levelStream, world, playerCam.target);
+SimAdvance(world, simClock, simInput, frameTime);
 
-    if(grounded){
-        crouching = 1;
-        player.size.y = crouchHeight;
+//every body gets its own playback, started a little later than the last one's so they don't all flip frames together
+if(spritesEnabled){
+    while(bodyPlayback.size() < world.bodies.size()){
+        SpritePlayback playback;
+        playback.time = bodyPlayback.size()*0.07f;
+        bodyPlayback.push_back(playback);
     }
-
+    for(SpritePlayback& playback : bodyPlayback) UpdateSpritePlayback(playback, frameTime);
 }
 
-if(IsKeyUp(KEY_S) && crouching){
-    crouching = 0;
-    sliding = 0;
-    player.position.y += -(playerHeight - crouchHeight);
-    player.size.y = playerHeight;
-}
-
-//a = f/m
-player.acc.y = (gravity*gravityModifier) + (player.force.y/player.mass);
-player.acc.x = player.force.x/player.mass;
-
-
-                    }
-
-
-
-
-
-void RunLogic() {
-
-
-//crouching logic
-
-
-//check timers
-/*
-for(const auto& t : vTimers){
-    if(GetTime() >= t.second){
-        *t.first = 1;
-    }
 }
-*/
 
-//the commented code below was for testing my raycasting implementation, 
-//it draws a line from 200, 200 to your cursor and draws a circle where the line intersects the first rectangle in the vRects vector.
-/*
-Vector2 ray_point = {200.0f, 200.0f};
-Vector2 ray_direction = Vector2Subtract(GetMousePosition(), ray_point);
+void DrawDebugInfo() {
 
-DrawLine(ray_point.x, ray_point.y, GetMousePosition().x, GetMousePosition().y, YELLOW);
-ray PlayerRay = RayVsRect(ray_point, ray_direction, vRects[0]);
+//debug player
+DrawText(TextFormat("X = %f, Y = %f, \n VelX = %f, VelY = %f, \n grounded = %i, crouched = %i, jumping = %i sliding = %i \n, gravMod = %f FPS = %i, width = %f, height = %f, \n brakingConstant = %f, mouseX = %f, mouseY = %f", player.position.x, player.position.y, player.velocity.x, player.velocity.y, world.grounded, world.crouching, world.jumping, world.sliding, world.gravityModifier, GetFPS(), player.size.x, player.size.y, world.brakingConstant, GetScreenToWorld2D(GetMousePosition(), currentCam).x,GetScreenToWorld2D(GetMousePosition(), currentCam).y ), 10, 10, 20, WHITE);
 
-if(PlayerRay.collided && PlayerRay.rayCheck <= 1)
-{
-    DrawRectangle(vRects[0].position.x, vRects[0].position.y, vRects[0].size.x, vRects[0].size.y, YELLOW);
-    DrawCircle(PlayerRay.contact_point.x, PlayerRay.contact_point.y, 5, RED);
-    DrawLine(PlayerRay.contact_point.x, PlayerRay.contact_point.y, PlayerRay.contact_point.x+5*PlayerRay.contact_normal.x, PlayerRay.contact_point.y + 5*PlayerRay.contact_normal.y, YELLOW);
-    
+if(KEY_JUMP == KEY_W){
+   DrawText(TextFormat("BJT: %f, Time: %f, KEYJUMP: W", world.bufferJumpTimer, world.time), 100, 100, 20, YELLOW); 
 }
-else {
-    DrawRectangle(vRects[0].position.x, vRects[0].position.y, vRects[0].size.x, vRects[0].size.y, WHITE);
+if(KEY_JUMP == KEY_SPACE){
+   DrawText(TextFormat("BJT: %f, Time: %f, KEYJUMP: SPACE", world.bufferJumpTimer, world.time), 100, 100, 20, YELLOW); 
 }
-*/
-
 
-//Press the left mouse button to make the player rectangle accelerate towards your cursor.
-//Press the "R" Key in order to reset the player's position and velocity to zero.
-vRects[0].velocity.x += vRects[0].acc.x * GetFrameTime();
-vRects[0].velocity.y += vRects[0].acc.y * GetFrameTime();
-
-//debug player
-DrawText(TextFormat("X = %f, Y = %f, \n VelX = %f, VelY = %f, \n grounded = %i, crouched = %i, jumping = %i sliding = %i \n, gravMod = %f FPS = %i, width = %f, height = %f, \n brakingConstant = %f, mouseX = %f, mouseY = %f", vRects[0].position.x, vRects[0].position.y, vRects[0].velocity.x, vRects[0].velocity.y, grounded, crouching, jumping, sliding, gravityModifier, GetFPS(), player.size.x, player.size.y, brakingConstant, GetScreenToWorld2D(GetMousePosition(), currentCam).x,GetScreenToWorld2D(GetMousePosition(), currentCam).y ), 10, 10, 20, WHITE);
-
-std::vector<collision> z;
-wallslidingRight = 0;
-wallslidingLeft = 0;
-grounded = 0;
-
-for(int i = 1; i < int(vRects.size()); i++)
-{ 
-    ray RectRay = DynamicRectVSRect(vRects[0], vRects[i]);
-    if(RectRay.collided && RectRay.rayCheck <= 1.0f){
-        z.push_back({i, RectRay.rayCheck, RectRay.type});
-    }
+DrawText(TextFormat("target.x = %f, target.y = %f, camMode = %i", currentCam.target.x, currentCam.target.y, cameraMode ), 100, 300, 20, WHITE);
+if(StreamActive(levelStream)) DrawText(TextFormat("chunks loaded = %i, in = %i, out = %i, rects added this frame = %i", int(levelStream.loaded.size()), levelStream.chunksLoaded, levelStream.chunksUnloaded, levelStream.addedLastUpdate), 100, 450, 20, WHITE);
+DrawText(TextFormat("extra sweeps = %i, sliders = %i, most sweeps = %i, capped = %i, out of budget = %i", world.toi.sweeps, world.toi.movers, world.toi.mostSweeps, world.toi.capped, world.toi.outOfBudget), 100, 540, 20, WHITE);
+if(spritesEnabled) DrawText(TextFormat("sprite draw calls = %i", spriteBatch.drawCalls), 100, 510, 20, WHITE);
+if(levelIOStatus[0] != 0) DrawText(levelIOStatus, 100, 480, 20, YELLOW);
+if(replayStatus[0] != 0) DrawText(TextFormat("replay: %s, %i frames", replayStatus, int(replay.frames.size())), 100, 420, 20, RED);
+DrawText(TextFormat("sim steps this frame = %i, step = %f, alpha = %f", simClock.stepsLastFrame, simClock.stepDt, simClock.alpha), 100, 360, 20, WHITE);
+DrawText(TextFormat("bodies = %i, awake = %i, islands asleep = %i, pairs tested = %i, contacts resolved = %i", int(world.bodies.size()), int(world.dynamics.active.size()), world.dynamics.sleepingIslands, world.dynamics.pairsTested, world.dynamics.contactsResolved), 100, 390, 20, WHITE);
+DrawText(TextFormat("cached tiles = %i, rebuilt = %i, statics drawn = %i, bodies drawn = %i", int(levelRenderer.tiles.size()), levelRenderer.tilesRebuilt, levelRenderer.staticsDrawn, levelRenderer.bodiesDrawn), 100, 330, 20, WHITE);
 
-    
 }
 
 
-//This should theoretically sort the collisions by shortest to longest, then resolve the shortest collision. If i screwed up then please tell me!
-std::sort(z.begin(), z.end(), [](const collision& a, const collision& b)
-{
-    return a.second < b.second;
-});
+void DrawGame(){
+PROFILE_SCOPE("DrawGame");
 
-for (auto j : z)
-if (DynamicRectVSRect(vRects[0], vRects[j.first]).collided)
-{
-    ray RectRay = DynamicRectVSRect(vRects[0], vRects[j.first]);
-    //grounded detection logic
-    if(RectRay.collided && RectRay.rayCheck <= 1 && RectRay.contact_normal.y == -1){
-        grounded = 1;
-    }
-    else{
-        grounded = 0;
-    }
-    
-    //wallslide detection logic
-    if(RectRay.collided && RectRay.rayCheck <= 1 && RectRay.contact_normal.x == -1){
-        wallslidingRight = 1;
-    }
-    else{
-        wallslidingRight = 0;
-    }
+//draws the static rectangles and the moving ones, only the ones the camera can see are drawn.
+//the player gets a one pixel expansion to make up for the one-pixel buffer i added to it.
+DrawLevel(levelRenderer, world, simClock);
 
-    if(RectRay.collided && RectRay.rayCheck <= 1 && RectRay.contact_normal.x == 1){
-        wallslidingLeft = 1;
+//holding L shows the player's line of sight to the mouse, it stops at the first solid rectangle
+if(IsKeyDown(KEY_L)){
+    Vector2 eye = {player.position.x + player.size.x/2, player.position.y + player.size.y/2};
+    Vector2 mouseWorld = GetScreenToWorld2D(GetMousePosition(), currentCam);
+    RaycastHit sight;
+    if(Raycast(world, eye, Vector2Subtract(mouseWorld, eye), sight, QUERY_TYPE(1))){
+        DrawLineV(eye, sight.point, RED);
+        DrawCircleV(sight.point, 3, RED);
     }
-    else{
-        wallslidingLeft = 0;
-    }
-
-    
-    //The collision is resolved by truncating the velocity to the point where the moving rectangle can never intersect with the static rectangle
-    //I also added a one-pixel buffer around the moving rectangle, as there were some issues with the origin of the raycast being from inside the static rectangle when the pixel buffer was removed.
-
-//Checks the type of rectangle that was collided with. If it's a wall, resolve collision. If it's a spike, kill the player.
-if(RectRay.type == 1){
-vRects[0].velocity = Vector2Add(Vector2Add(vRects[0].velocity, Vector2{RectRay.contact_normal.x, RectRay.contact_normal.y}), Vector2Multiply(RectRay.contact_normal, Vector2Scale((Vector2){fabsf(vRects[0].velocity.x), fabsf(vRects[0].velocity.y)}, (1-RectRay.rayCheck))));
-}
-else if(RectRay.type == 2){
-playerDeath();
+    else DrawLineV(eye, mouseWorld, GREEN);
 }
 
-}
 
-if(jumping && sliding){
-    brakingConstant = 0;
-}
-else {
-    brakingConstant = 30;
-}
+if(spritesEnabled){
+    Rectangle view = CameraWorldRect(currentCam);
+    for(int i = 0; i < int(world.bodies.size()); i++){
+        if(i == world.playerBody) continue;
+        Vector2 position = InterpolatedPosition(world, simClock, i);
+        Rectangle dest = {position.x, position.y, world.bodies[i].size.x, world.bodies[i].size.y};
+        if(rectsOverlap(dest, view)) SpriteBatchAddAnimation(spriteBatch, framePool, dogeAnimation, bodyPlayback[i], dest, WHITE);
+    }
 
-if(grounded){
-groundedCoyoteTimer = GetTime() + groundedCoyoteWindow;
+    //the seal is drawn over the bodies, and a bit wider than the player since the sprite has a tail
+    Vector2 position = InterpolatedPosition(world, simClock, world.playerBody);
+    Rectangle dest = {position.x - 8, position.y, 26*2, 19*2};
+    SpriteBatchAddAnimation(spriteBatch, framePool, sealAnimation, bodyPlayback[world.playerBody], dest, WHITE, 1);
+    SpriteBatchSubmit(spriteBatch);
 }
 
-if(wallslidingLeft){
-wallslideLeftCoyoteTimer = GetTime() + wallslideCoyoteWindow;
 }
 
-if(wallslidingRight){
-wallslideRightCoyoteTimer = GetTime() + wallslideCoyoteWindow;
-}
-//caps the player's downwards vertical speed when wallsliding
-if((wallslidingLeft || wallslidingRight) && player.velocity.y > 100){
-    player.velocity.y = 100;
-}
+void DrawMenus() {
 
-//if the player's velocity is too slow, they won't be counted as sliding anymore
-if(std::abs(player.velocity.x) < 200 && sliding){
-    sliding = 0;
 }
 
-if((std::abs(player.velocity.x) < 1)){
-    player.velocity.x = 0;
-}
-//change the moving rectangle's position by its velocity modulated by deltaTime
+#ifdef SIM_PROFILE
+//P shows the profiler: the last few seconds of frame times as bars (the line is 60 fps) and where the last frame went.
+//F8 writes everything still in the profiler's buffer to trace.json (for chrome://tracing) and trace.csv.
+bool profilerVisible = false;
 
-vRects[0].position.x += vRects[0].velocity.x * GetFrameTime();
-vRects[0].position.y += vRects[0].velocity.y * GetFrameTime();
+void DrawProfiler(){
+if(IsKeyPressed(KEY_P)) profilerVisible = !profilerVisible;
+if(IsKeyPressed(KEY_F8)){
+    ProfileWriteChromeTrace("trace.json");
+    ProfileWriteCSV("trace.csv");
 }
+if(!profilerVisible) return;
 
+static ProfileFrame frames[PROFILE_MAX_FRAMES];
+int count = ProfileRecentFrames(frames, PROFILE_MAX_FRAMES);
 
-Vector2 rectangleOffset;
-
-void DrawGame(){
-
-//automatically draws each rectangle in the vRects vector, plus a one pixel expansion to make up for the one-pixel buffer i added to the player.
-//if there is a more elegant way for this to work, please tell me.
-for(const auto& r : vRects){
-    Color RectColor;
-    rectangleOffset = Vector2 {0,0};
-
-if(r.type == 0) {
-    RectColor = YELLOW;
-    rectangleOffset = Vector2 {1, 1};
-    }
-if(r.type == 1) RectColor = WHITE;
-if(r.type == 2) RectColor = RED;
-    DrawRectangle(r.position.x, r.position.y, r.size.x +rectangleOffset.x, r.size.y+rectangleOffset.y, RectColor);
-
+//2 pixels wide per frame, 4 pixels tall per millisecond
+const int left = 10, bottom = GetScreenHeight() - 10, graphHeight = 120;
+DrawRectangle(left, bottom - graphHeight, PROFILE_MAX_FRAMES*2, graphHeight, Color {0, 0, 0, 160});
+for(int i = 0; i < count; i++){
+    float ms = frames[i].duration / 1e6f;
+    int height = std::min(graphHeight, int(ms*4));
+    Color color = ms > 1000.0f/60.0f ? RED : GREEN;
+    DrawRectangle(left + i*2, bottom - height, 2, height, color);
 }
+DrawLine(left, bottom - int(4*1000.0f/60.0f), left + PROFILE_MAX_FRAMES*2, bottom - int(4*1000.0f/60.0f), YELLOW);
 
-
-//unused code for graphics, may or may not use later
-/*Rectangle source = Rectangle {0, 0, 26, 19};
-Rectangle dest = Rectangle {player.position.x-8, player.position.y, source.width*2, source.height*2};
-
-DrawTexturePro(playerSprite, source, dest, Vector2 {0,0}, 0, WHITE);*/
-
+const char* zones[] = {"GetInput", "RunLogic", "SimStep", "broadphase", "narrowphase", "resolve", "StepBodies", "MoveCamera", "DrawGame"};
+int y = bottom - graphHeight - 20*int(sizeof(zones)/sizeof(zones[0])) - 10;
+for(const char* zone : zones){
+    DrawText(TextFormat("%-12s %7.3f ms", zone, ProfileLastFrameTime(zone) / 1e6), left, y, 20, WHITE);
+    y += 20;
 }
-
-void DrawMenus() {
-
 }
+#endif
 
 
-int main()
+int main(int argc, char** argv)
 {
 
     const int screenWidth = 1280;
@@ -786,7 +429,10 @@ int main()
     InitWindow(screenWidth, screenHeight, "2d Collision Prototype");
     SetTargetFPS(60);
     SetupGame();
-    saveLevel();
+    //a streamed level (see levelconv) replaces the one SetupGame loaded
+    size_t levelLength = argc > 1 ? strlen(argv[1]) : 0;
+    if(levelLength > 4 && strcmp(argv[1] + levelLength - 4, ".rvs") == 0) StreamOpen(levelStream, world, argv[1]);
+    else LevelSaveAsync(levelIO, world, "LevelOne.txt", false);
     while (!WindowShouldClose())
     {
         BeginDrawing();
@@ -794,14 +440,23 @@ int main()
         ClearBackground(BLACK);
         GetInput();
         RunLogic();
+        DrawDebugInfo();
+#ifdef SIM_PROFILE
+        DrawProfiler();
+#endif
         DrawMenus();
         MoveCamera();
         DrawGame();
         EndMode2D();
         EndDrawing();
+        PROFILE_FRAME();
 
     }
 
+    //lets a save that's still being written finish
+    LevelIOShutdown(levelIO);
+    UnloadLevelRenderer(levelRenderer);
+    JobsShutdown(jobs);
     CloseWindow();
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,149 @@
+#include "profile.h"
+
+#include <cstdio>
+#include <cstring>
+
+#ifdef SIM_PROFILE
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+static const std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+
+static long long Now(){
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin).count();
+}
+
+//every thread gets a small number the first time it records something, the thread that starts first is 0
+static std::atomic<int> threadCount {0};
+static thread_local int threadId = -1;
+static thread_local int depth = 0;
+
+//scopes from any thread claim the next slot with one atomic add, so the job threads can record too
+static ProfileEvent events[PROFILE_MAX_EVENTS];
+static std::atomic<unsigned long long> eventCount {0};
+static std::atomic<unsigned int> currentFrame {0};
+
+//frames are only ended on the main thread
+static ProfileFrame frames[PROFILE_MAX_FRAMES];
+static unsigned int frameCount = 0;
+static long long frameStart = 0;
+
+struct ZoneTotal {
+    const char* name;
+    long long total;
+};
+static std::vector<ZoneTotal> lastFrameTotals;
+
+ProfileScope::ProfileScope(const char* name) : name(name){
+    depth++;
+    start = Now();
+}
+
+ProfileScope::~ProfileScope(){
+    long long end = Now();
+    depth--;
+    if(threadId < 0) threadId = threadCount++;
+
+    unsigned long long slot = eventCount++ % PROFILE_MAX_EVENTS;
+    ProfileEvent& e = events[slot];
+    e.name = name;
+    e.start = start;
+    e.duration = end - start;
+    e.thread = threadId;
+    e.depth = depth;
+    e.frame = currentFrame.load(std::memory_order_relaxed);
+}
+
+void ProfileEndFrame(){
+    long long now = Now();
+    unsigned int finished = currentFrame.load(std::memory_order_relaxed);
+
+    frames[frameCount % PROFILE_MAX_FRAMES] = ProfileFrame {frameStart, now - frameStart};
+    frameCount++;
+    frameStart = now;
+
+    //totals for the frame that just ended, walking back from the newest event until an older frame shows up.
+    lastFrameTotals.clear();
+    unsigned long long count = eventCount.load();
+    unsigned long long oldest = count > PROFILE_MAX_EVENTS ? count - PROFILE_MAX_EVENTS : 0;
+    for(unsigned long long i = count; i > oldest; i--){
+        const ProfileEvent& e = events[(i - 1) % PROFILE_MAX_EVENTS];
+        if(e.frame != finished) break;
+
+        bool found = 0;
+        for(ZoneTotal& zone : lastFrameTotals){
+            if(zone.name == e.name){
+                zone.total += e.duration;
+                found = 1;
+                break;
+            }
+        }
+        if(!found) lastFrameTotals.push_back(ZoneTotal {e.name, e.duration});
+    }
+
+    currentFrame.store(finished + 1, std::memory_order_relaxed);
+}
+
+int ProfileRecentFrames(ProfileFrame* out, int count){
+    if(count > PROFILE_MAX_FRAMES) count = PROFILE_MAX_FRAMES;
+    if(count > int(frameCount)) count = int(frameCount);
+    for(int i = 0; i < count; i++){
+        out[i] = frames[(frameCount - count + i) % PROFILE_MAX_FRAMES];
+    }
+    return count;
+}
+
+long long ProfileLastFrameTime(const char* name){
+    long long total = 0;
+    for(const ZoneTotal& zone : lastFrameTotals){
+        if(zone.name == name || strcmp(zone.name, name) == 0) total += zone.total;
+    }
+    return total;
+}
+
+//calls fn on every event still in the ring, oldest first
+template <typename Fn>
+static void EachEvent(Fn fn){
+    unsigned long long count = eventCount.load();
+    unsigned long long oldest = count > PROFILE_MAX_EVENTS ? count - PROFILE_MAX_EVENTS : 0;
+    for(unsigned long long i = oldest; i < count; i++) fn(events[i % PROFILE_MAX_EVENTS]);
+}
+
+bool ProfileWriteChromeTrace(const char* fileName){
+    FILE* file = fopen(fileName, "w");
+    if(file == NULL) return 0;
+
+    //complete ("X") events with microsecond times, the viewer works out the nesting from them
+    fprintf(file, "{\"traceEvents\":[\n");
+    bool first = 1;
+    EachEvent([&](const ProfileEvent& e){
+        fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%u}}",
+                first ? "" : ",\n", e.name, e.thread, e.start / 1000.0, e.duration / 1000.0, e.frame);
+        first = 0;
+    });
+    fprintf(file, "\n],\"displayTimeUnit\":\"ms\"}\n");
+    return fclose(file) == 0;
+}
+
+bool ProfileWriteCSV(const char* fileName){
+    FILE* file = fopen(fileName, "w");
+    if(file == NULL) return 0;
+
+    fprintf(file, "frame,thread,depth,name,start_us,duration_us\n");
+    EachEvent([&](const ProfileEvent& e){
+        fprintf(file, "%u,%d,%d,%s,%.3f,%.3f\n", e.frame, e.thread, e.depth, e.name, e.start / 1000.0, e.duration / 1000.0);
+    });
+    return fclose(file) == 0;
+}
+
+#else
+
+void ProfileEndFrame(){}
+int ProfileRecentFrames(ProfileFrame*, int){ return 0; }
+long long ProfileLastFrameTime(const char*){ return 0; }
+bool ProfileWriteChromeTrace(const char*){ return 0; }
+bool ProfileWriteCSV(const char*){ return 0; }
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef PROFILE_H_
+#define PROFILE_H_
+
+//scoped timers for finding out where a frame goes. PROFILE_SCOPE("name") times from there to the end of the block,
+//PROFILE_FRAME() marks the end of a frame. the timings go into ring buffers, which the game draws as a frame time graph
+//and which can be written out as a chrome trace (open it in chrome://tracing or ui.perfetto.dev) or as csv.
+//
+//it's only compiled in when SIM_PROFILE is defined (make PROFILE=1). without it the macros are empty,
+//so the timers can stay in the code for release builds.
+//names have to be string literals (or anything else that lives forever), only the pointer is stored.
+
+#define PROFILE_MAX_EVENTS 65536
+#define PROFILE_MAX_FRAMES 240
+
+struct ProfileEvent {
+    const char* name;
+    long long start, duration;     //nanoseconds since the profiler started
+    int thread;
+    int depth;                     //how many scopes this one is inside of, on its thread
+    unsigned int frame;
+};
+
+struct ProfileFrame {
+    long long start, duration;
+};
+
+#ifdef SIM_PROFILE
+
+struct ProfileScope {
+    const char* name;
+    long long start;
+    explicit ProfileScope(const char* name);
+    ~ProfileScope();
+};
+
+#define PROFILE_CONCAT2(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT2(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_FRAME() ProfileEndFrame()
+
+#else
+
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_FRAME() ((void)0)
+
+#endif
+
+//the rest is always declared so tools can call it, without SIM_PROFILE there's just never anything recorded
+
+void ProfileEndFrame();
+
+//copies out the last count frames, oldest first. returns how many there were.
+int ProfileRecentFrames(ProfileFrame* out, int count);
+
+//the total time spent in scopes called name during the last finished frame, in nanoseconds
+long long ProfileLastFrameTime(const char* name);
+
+//everything still in the ring buffer, oldest first
+bool ProfileWriteChromeTrace(const char* fileName);
+bool ProfileWriteCSV(const char* fileName);
+
+#endif
@@ -0,0 +1,153 @@
+#include "query.h"
+#include "sim.h"
+#include "jobs.h"
+
+#include <math.h>
+#include <algorithm>
+
+static void SortUnique(std::vector<int>& ids){
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+}
+
+//the type comes straight from the level file, so it can be anything up to 255. types past 31 have no bit in the mask
+//(shifting by that much isn't defined), they only get through when every type is asked for.
+static bool TypeAllowed(const SimWorld& world, int i, unsigned int types){
+    int type = world.statics.type[i];
+    if(type >= 32) return types == QUERY_ALL_TYPES;
+    return (types & QUERY_TYPE(type)) != 0;
+}
+
+//the collision layers the types are on, so a query for spikes only walks the hazards and a line of sight only the solids.
+//types 32 and up can't be named in the mask, so asking for every type asks for every layer.
+static unsigned int LayersFor(const SimWorld& world, unsigned int types){
+    if(types == QUERY_ALL_TYPES) return LAYER_ALL;
+    unsigned int layers = 0;
+    for(int type = 0; type < 32; type++){
+        if(types & QUERY_TYPE(type)) layers |= StaticLayer(world, type);
+    }
+    return layers;
+}
+
+//working space for one query. it's per thread so the batch can run queries from the job threads.
+struct QueryScratch {
+    std::vector<int> candidates;
+    RectSoA rects;
+    RayBatchResult result;
+    std::vector<int> ids;      //which static each entry of rects is
+};
+static thread_local QueryScratch scratch;
+
+//casts one ray (grown by expand, like DynamicRectVSRect does) against the candidates that pass the type mask
+static int CastCandidates(const SimWorld& world, Vector2 origin, Vector2 dir, Vector2 expand, unsigned int types){
+    SoAClear(scratch.rects);
+    scratch.ids.clear();
+
+    const RectSoA& statics = world.statics;
+    for(int i : scratch.candidates){
+        if(!TypeAllowed(world, i, types)) continue;
+        SoAPush(scratch.rects, statics.x[i], statics.y[i], statics.w[i], statics.h[i], statics.type[i]);
+        scratch.ids.push_back(i);
+    }
+    return RayVsRectBatch(origin, dir, expand, 1.0f, scratch.rects, scratch.result);
+}
+
+static RaycastHit MakeHit(const SimWorld& world, const RayBatchResult& result, int k, int collider, Vector2 origin, Vector2 dir){
+    RaycastHit hit;
+    hit.collider = collider;
+    hit.type = world.statics.type[collider];
+    if(result.tHitNear[k] < 0){
+        hit.t = 0;
+        hit.normal = Vector2 {0, 0};
+    }
+    else{
+        hit.t = result.tHitNear[k];
+        hit.normal = Vector2 {result.normalX[k], result.normalY[k]};
+    }
+    hit.point = Vector2 {origin.x + dir.x*hit.t, origin.y + dir.y*hit.t};
+    return hit;
+}
+
+static const RaycastHit noHit = {-1, 1, {0, 0}, {0, 0}, 0};
+
+//the nearest of the hits, ties go to the lower index since the candidates are sorted
+static bool NearestHit(const SimWorld& world, Vector2 origin, Vector2 dir, Vector2 expand, unsigned int types, RaycastHit& hit){
+    hit = noHit;
+    if(CastCandidates(world, origin, dir, expand, types) == 0) return 0;
+
+    const RayBatchResult& result = scratch.result;
+    int best = -1;
+    for(int k = 0; k < int(scratch.ids.size()); k++){
+        if(!result.hit[k]) continue;
+        if(best < 0 || std::max(result.tHitNear[k], 0.0f) < std::max(result.tHitNear[best], 0.0f)) best = k;
+    }
+    hit = MakeHit(world, result, best, scratch.ids[best], origin, dir);
+    return 1;
+}
+
+static void RayCandidates(const SimWorld& world, Vector2 origin, Vector2 dir, unsigned int types){
+    scratch.candidates.clear();
+    RaycastStatics(world, origin, dir, scratch.candidates, LayersFor(world, types));
+    SortUnique(scratch.candidates);
+}
+
+bool Raycast(const SimWorld& world, Vector2 origin, Vector2 dir, RaycastHit& hit, unsigned int types){
+    RayCandidates(world, origin, dir, types);
+    return NearestHit(world, origin, dir, Vector2 {0, 0}, types, hit);
+}
+
+int RaycastAll(const SimWorld& world, Vector2 origin, Vector2 dir, std::vector<RaycastHit>& hits, unsigned int types){
+    RayCandidates(world, origin, dir, types);
+    if(CastCandidates(world, origin, dir, Vector2 {0, 0}, types) == 0) return 0;
+
+    size_t first = hits.size();
+    for(int k = 0; k < int(scratch.ids.size()); k++){
+        if(scratch.result.hit[k]) hits.push_back(MakeHit(world, scratch.result, k, scratch.ids[k], origin, dir));
+    }
+    std::stable_sort(hits.begin() + first, hits.end(), [](const RaycastHit& a, const RaycastHit& b){ return a.t < b.t; });
+    return int(hits.size() - first);
+}
+
+bool SweepAABB(const SimWorld& world, Rectangle box, Vector2 displacement, RaycastHit& hit, unsigned int types){
+    //the area the box covers over the whole move, padded by a pixel like sweptBounds
+    Rectangle area;
+    area.x = std::min(box.x, box.x + displacement.x) - 1;
+    area.y = std::min(box.y, box.y + displacement.y) - 1;
+    area.width = box.width + fabsf(displacement.x) + 2;
+    area.height = box.height + fabsf(displacement.y) + 2;
+
+    scratch.candidates.clear();
+    QueryStaticsShared(world, area, scratch.candidates, LayersFor(world, types));
+    SortUnique(scratch.candidates);
+
+    Vector2 center = {box.x + box.width/2, box.y + box.height/2};
+    return NearestHit(world, center, displacement, Vector2 {box.width, box.height}, types, hit);
+}
+
+int OverlapAABB(const SimWorld& world, Rectangle area, std::vector<int>& out, unsigned int types){
+    scratch.candidates.clear();
+    QueryStaticsShared(world, area, scratch.candidates, LayersFor(world, types));
+    SortUnique(scratch.candidates);
+
+    int found = 0;
+    for(int i : scratch.candidates){
+        if(!TypeAllowed(world, i, types) || !rectsOverlap(area, staticBounds(world, i))) continue;
+        out.push_back(i);
+        found++;
+    }
+    return found;
+}
+
+int OverlapPoint(const SimWorld& world, Vector2 point, std::vector<int>& out, unsigned int types){
+    return OverlapAABB(world, Rectangle {point.x, point.y, 0, 0}, out, types);
+}
+
+int RaycastBatch(const SimWorld& world, const RayQuery* rays, int count, RaycastHit* hits, unsigned int types, JobSystem* jobs){
+    ParallelFor(jobs, count, 64, [&](int, int begin, int end){
+        for(int i = begin; i < end; i++) Raycast(world, rays[i].origin, rays[i].dir, hits[i], types);
+    });
+
+    int hitCount = 0;
+    for(int i = 0; i < count; i++) hitCount += hits[i].collider >= 0;
+    return hitCount;
+}
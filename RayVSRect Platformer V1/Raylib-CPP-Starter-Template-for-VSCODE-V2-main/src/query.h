@@ -0,0 +1,56 @@
+#ifndef QUERY_H_
+#define QUERY_H_
+
+#include "raylib.h"
+#include <cstddef>
+#include <vector>
+
+struct SimWorld;
+struct JobSystem;
+
+//gameplay queries against the level's static rectangles: line of sight, hitscan, "is anything here".
+//they go through the grid and the tree, so they only look at the rectangles near the ray or area.
+//none of them change the world, so they can be run from several threads at once.
+
+//types is a mask of which rectangle types count, bit (1 << type). QUERY_ALL_TYPES lets everything through,
+//and it's the only way to match types 32 and up. QUERY_TYPE only takes 0 to 31.
+#define QUERY_ALL_TYPES 0xffffffffu
+#define QUERY_TYPE(t) (1u << (t))
+
+//what a ray or a swept box ran into. a ray is a segment from origin to origin + dir, t goes from 0 to 1 along it.
+//something the ray starts inside is hit at t = 0 with a zero normal.
+struct RaycastHit {
+    int collider;       //index into SimWorld::statics, -1 for a miss
+    float t;
+    Vector2 point;
+    Vector2 normal;
+    int type;
+};
+
+struct RayQuery {
+    Vector2 origin;
+    Vector2 dir;
+};
+
+//the nearest rectangle the segment hits. returns false (and collider -1) if there isn't one.
+bool Raycast(const SimWorld& world, Vector2 origin, Vector2 dir, RaycastHit& hit, unsigned int types = QUERY_ALL_TYPES);
+
+//every rectangle the segment hits, nearest first. returns how many were appended to hits.
+int RaycastAll(const SimWorld& world, Vector2 origin, Vector2 dir, std::vector<RaycastHit>& hits, unsigned int types = QUERY_ALL_TYPES);
+
+//the first rectangle a box moving by displacement runs into, the same test DynamicRectVSRect does.
+//point is where the box's center is when it hits.
+bool SweepAABB(const SimWorld& world, Rectangle box, Vector2 displacement, RaycastHit& hit, unsigned int types = QUERY_ALL_TYPES);
+
+//appends every rectangle overlapping the area (touching edges count, like rectsOverlap), in index order
+int OverlapAABB(const SimWorld& world, Rectangle area, std::vector<int>& out, unsigned int types = QUERY_ALL_TYPES);
+
+//appends every rectangle containing the point, in index order
+int OverlapPoint(const SimWorld& world, Vector2 point, std::vector<int>& out, unsigned int types = QUERY_ALL_TYPES);
+
+//Raycast for count rays at once, hits[i] is the answer for rays[i]. if jobs isn't NULL the rays are split across its threads.
+//returns how many of them hit something.
+int RaycastBatch(const SimWorld& world, const RayQuery* rays, int count, RaycastHit* hits,
+                 unsigned int types = QUERY_ALL_TYPES, JobSystem* jobs = NULL);
+
+#endif
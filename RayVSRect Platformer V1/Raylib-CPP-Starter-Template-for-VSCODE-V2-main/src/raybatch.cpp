@@ -0,0 +1,213 @@
+#include "raybatch.h"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <cmath>
+
+void SoAClear(RectSoA& soa){
+    soa.x.clear();
+    soa.y.clear();
+    soa.w.clear();
+    soa.h.clear();
+    soa.type.clear();
+}
+
+void SoAPush(RectSoA& soa, float x, float y, float w, float h, unsigned char type){
+    soa.x.push_back(x);
+    soa.y.push_back(y);
+    soa.w.push_back(w);
+    soa.h.push_back(h);
+    soa.type.push_back(type);
+}
+
+//one rectangle, written to do the exact same float operations in the same order as RayVsRect
+static inline int RayVsRectOne(Vector2 o, Vector2 d, Vector2 half, Vector2 expand, float maxT,
+                               float x, float y, float w, float h,
+                               unsigned char& hit, float& tHitNear, float& normalX, float& normalY){
+    float ex = x - half.x;
+    float ey = y - half.y;
+    float ew = w + expand.x;
+    float eh = h + expand.y;
+
+    float tnx = (ex - o.x) / d.x;
+    float tny = (ey - o.y) / d.y;
+    float tfx = (ex + (ew - o.x)) / d.x;
+    float tfy = (ey + (eh - o.y)) / d.y;
+
+    hit = 0;
+    tHitNear = 0;
+    normalX = 0;
+    normalY = 0;
+
+    if(std::isnan(tfx) || std::isnan(tfy) || std::isnan(tnx) || std::isnan(tny)) return 0;
+
+    if(tnx > tfx){ float t = tnx; tnx = tfx; tfx = t; }
+    if(tny > tfy){ float t = tny; tny = tfy; tfy = t; }
+
+    if(tnx > tfy || tny > tfx) return 0;
+
+    float tNear = (tnx < tny) ? tny : tnx;
+    float tFar = (tfy < tfx) ? tfy : tfx;
+
+    if(tFar < 0 || tNear > maxT) return 0;
+
+    hit = 1;
+    tHitNear = tNear;
+    if(tnx > tny) normalX = d.x < 0 ? 1.0f : -1.0f;
+    else if(tnx < tny) normalY = d.y < 0 ? 1.0f : -1.0f;
+    return 1;
+}
+
+#if defined(__AVX__)
+
+//same kernel, 8 rectangles at a time. every branch of the scalar version becomes a mask and a blend.
+static int RayVsRectWide(Vector2 o, Vector2 d, Vector2 half, Vector2 expand, float maxT,
+                         const float* x, const float* y, const float* w, const float* h, int count,
+                         unsigned char* hit, float* tHitNear, float* normalX, float* normalY){
+    const __m256 ox = _mm256_set1_ps(o.x), oy = _mm256_set1_ps(o.y);
+    const __m256 dx = _mm256_set1_ps(d.x), dy = _mm256_set1_ps(d.y);
+    const __m256 hx = _mm256_set1_ps(half.x), hy = _mm256_set1_ps(half.y);
+    const __m256 sx = _mm256_set1_ps(expand.x), sy = _mm256_set1_ps(expand.y);
+    const __m256 zero = _mm256_setzero_ps(), limit = _mm256_set1_ps(maxT);
+    const __m256 nx = _mm256_set1_ps(d.x < 0 ? 1.0f : -1.0f), ny = _mm256_set1_ps(d.y < 0 ? 1.0f : -1.0f);
+
+    int hits = 0;
+    int i = 0;
+    for(; i + 8 <= count; i += 8){
+        __m256 ex = _mm256_sub_ps(_mm256_loadu_ps(x + i), hx);
+        __m256 ey = _mm256_sub_ps(_mm256_loadu_ps(y + i), hy);
+        __m256 ew = _mm256_add_ps(_mm256_loadu_ps(w + i), sx);
+        __m256 eh = _mm256_add_ps(_mm256_loadu_ps(h + i), sy);
+
+        __m256 tnx = _mm256_div_ps(_mm256_sub_ps(ex, ox), dx);
+        __m256 tny = _mm256_div_ps(_mm256_sub_ps(ey, oy), dy);
+        __m256 tfx = _mm256_div_ps(_mm256_add_ps(ex, _mm256_sub_ps(ew, ox)), dx);
+        __m256 tfy = _mm256_div_ps(_mm256_add_ps(ey, _mm256_sub_ps(eh, oy)), dy);
+
+        __m256 valid = _mm256_and_ps(_mm256_cmp_ps(tnx, tfx, _CMP_ORD_Q), _mm256_cmp_ps(tny, tfy, _CMP_ORD_Q));
+
+        __m256 swapX = _mm256_cmp_ps(tnx, tfx, _CMP_GT_OQ);
+        __m256 swapY = _mm256_cmp_ps(tny, tfy, _CMP_GT_OQ);
+        __m256 nearX = _mm256_blendv_ps(tnx, tfx, swapX), farX = _mm256_blendv_ps(tfx, tnx, swapX);
+        __m256 nearY = _mm256_blendv_ps(tny, tfy, swapY), farY = _mm256_blendv_ps(tfy, tny, swapY);
+
+        valid = _mm256_andnot_ps(_mm256_or_ps(_mm256_cmp_ps(nearX, farY, _CMP_GT_OQ), _mm256_cmp_ps(nearY, farX, _CMP_GT_OQ)), valid);
+
+        __m256 tNear = _mm256_blendv_ps(nearX, nearY, _mm256_cmp_ps(nearX, nearY, _CMP_LT_OQ));
+        __m256 tFar = _mm256_blendv_ps(farX, farY, _mm256_cmp_ps(farY, farX, _CMP_LT_OQ));
+
+        valid = _mm256_andnot_ps(_mm256_or_ps(_mm256_cmp_ps(tFar, zero, _CMP_LT_OQ), _mm256_cmp_ps(tNear, limit, _CMP_GT_OQ)), valid);
+
+        __m256 normX = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(nearX, nearY, _CMP_GT_OQ), nx), valid);
+        __m256 normY = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(nearX, nearY, _CMP_LT_OQ), ny), valid);
+
+        _mm256_storeu_ps(tHitNear + i, _mm256_and_ps(tNear, valid));
+        _mm256_storeu_ps(normalX + i, normX);
+        _mm256_storeu_ps(normalY + i, normY);
+
+        int mask = _mm256_movemask_ps(valid);
+        for(int k = 0; k < 8; k++) hit[i + k] = (mask >> k) & 1;
+        hits += __builtin_popcount(mask);
+    }
+    return hits;
+}
+
+#elif defined(__SSE2__)
+
+//SSE2 has no blend instruction, so selects are done with and/andnot/or
+static inline __m128 Select(__m128 mask, __m128 a, __m128 b){
+    return _mm_or_ps(_mm_and_ps(mask, b), _mm_andnot_ps(mask, a));
+}
+
+//same kernel, 4 rectangles at a time. every branch of the scalar version becomes a mask and a select.
+static int RayVsRectWide(Vector2 o, Vector2 d, Vector2 half, Vector2 expand, float maxT,
+                         const float* x, const float* y, const float* w, const float* h, int count,
+                         unsigned char* hit, float* tHitNear, float* normalX, float* normalY){
+    const __m128 ox = _mm_set1_ps(o.x), oy = _mm_set1_ps(o.y);
+    const __m128 dx = _mm_set1_ps(d.x), dy = _mm_set1_ps(d.y);
+    const __m128 hx = _mm_set1_ps(half.x), hy = _mm_set1_ps(half.y);
+    const __m128 sx = _mm_set1_ps(expand.x), sy = _mm_set1_ps(expand.y);
+    const __m128 zero = _mm_setzero_ps(), limit = _mm_set1_ps(maxT);
+    const __m128 nx = _mm_set1_ps(d.x < 0 ? 1.0f : -1.0f), ny = _mm_set1_ps(d.y < 0 ? 1.0f : -1.0f);
+
+    int hits = 0;
+    int i = 0;
+    for(; i + 4 <= count; i += 4){
+        __m128 ex = _mm_sub_ps(_mm_loadu_ps(x + i), hx);
+        __m128 ey = _mm_sub_ps(_mm_loadu_ps(y + i), hy);
+        __m128 ew = _mm_add_ps(_mm_loadu_ps(w + i), sx);
+        __m128 eh = _mm_add_ps(_mm_loadu_ps(h + i), sy);
+
+        __m128 tnx = _mm_div_ps(_mm_sub_ps(ex, ox), dx);
+        __m128 tny = _mm_div_ps(_mm_sub_ps(ey, oy), dy);
+        __m128 tfx = _mm_div_ps(_mm_add_ps(ex, _mm_sub_ps(ew, ox)), dx);
+        __m128 tfy = _mm_div_ps(_mm_add_ps(ey, _mm_sub_ps(eh, oy)), dy);
+
+        __m128 valid = _mm_and_ps(_mm_cmpord_ps(tnx, tfx), _mm_cmpord_ps(tny, tfy));
+
+        __m128 swapX = _mm_cmpgt_ps(tnx, tfx);
+        __m128 swapY = _mm_cmpgt_ps(tny, tfy);
+        __m128 nearX = Select(swapX, tnx, tfx), farX = Select(swapX, tfx, tnx);
+        __m128 nearY = Select(swapY, tny, tfy), farY = Select(swapY, tfy, tny);
+
+        valid = _mm_andnot_ps(_mm_or_ps(_mm_cmpgt_ps(nearX, farY), _mm_cmpgt_ps(nearY, farX)), valid);
+
+        __m128 tNear = Select(_mm_cmplt_ps(nearX, nearY), nearX, nearY);
+        __m128 tFar = Select(_mm_cmplt_ps(farY, farX), farX, farY);
+
+        valid = _mm_andnot_ps(_mm_or_ps(_mm_cmplt_ps(tFar, zero), _mm_cmpgt_ps(tNear, limit)), valid);
+
+        __m128 normX = _mm_and_ps(_mm_and_ps(_mm_cmpgt_ps(nearX, nearY), nx), valid);
+        __m128 normY = _mm_and_ps(_mm_and_ps(_mm_cmplt_ps(nearX, nearY), ny), valid);
+
+        _mm_storeu_ps(tHitNear + i, _mm_and_ps(tNear, valid));
+        _mm_storeu_ps(normalX + i, normX);
+        _mm_storeu_ps(normalY + i, normY);
+
+        int mask = _mm_movemask_ps(valid);
+        for(int k = 0; k < 4; k++) hit[i + k] = (mask >> k) & 1;
+        hits += (mask & 1) + ((mask >> 1) & 1) + ((mask >> 2) & 1) + ((mask >> 3) & 1);
+    }
+    return hits;
+}
+
+#endif
+
+int RayVsRectBatch(Vector2 ray_origin, Vector2 ray_dir, Vector2 expand, float maxT,
+                   const float* x, const float* y, const float* w, const float* h, int count,
+                   unsigned char* hit, float* tHitNear, float* normalX, float* normalY){
+    Vector2 half = {expand.x/2, expand.y/2};
+    int hits = 0;
+    int done = 0;
+
+#if defined(__AVX__) || defined(__SSE2__)
+#if defined(__AVX__)
+    const int width = 8;
+#else
+    const int width = 4;
+#endif
+    done = count - count % width;
+    hits += RayVsRectWide(ray_origin, ray_dir, half, expand, maxT, x, y, w, h, done, hit, tHitNear, normalX, normalY);
+#endif
+
+    for(int i = done; i < count; i++){
+        hits += RayVsRectOne(ray_origin, ray_dir, half, expand, maxT, x[i], y[i], w[i], h[i], hit[i], tHitNear[i], normalX[i], normalY[i]);
+    }
+    return hits;
+}
+
+int RayVsRectBatch(Vector2 ray_origin, Vector2 ray_dir, Vector2 expand, float maxT, const RectSoA& rects, RayBatchResult& result){
+    int count = SoACount(rects);
+    result.hit.resize(count);
+    result.tHitNear.resize(count);
+    result.normalX.resize(count);
+    result.normalY.resize(count);
+    if(count == 0) return 0;
+
+    return RayVsRectBatch(ray_origin, ray_dir, expand, maxT, rects.x.data(), rects.y.data(), rects.w.data(), rects.h.data(), count,
+                          result.hit.data(), result.tHitNear.data(), result.normalX.data(), result.normalY.data());
+}
@@ -0,0 +1,36 @@
+#ifndef RAYBATCH_H_
+#define RAYBATCH_H_
+
+#include "raylib.h"
+#include <vector>
+
+//rectangles stored as a structure of arrays, one array per field, so the batched kernels can load 4 or 8 of them at once
+struct RectSoA {
+    std::vector<float> x, y, w, h;
+    std::vector<unsigned char> type;
+};
+
+void SoAClear(RectSoA& soa);
+void SoAPush(RectSoA& soa, float x, float y, float w, float h, unsigned char type);
+inline int SoACount(const RectSoA& soa){ return int(soa.x.size()); }
+
+//the results of one batched ray test, one entry per rectangle.
+//hit is 1 where RayVsRect would have returned a collided ray, normals are -1, 0 or 1 like contact_normal.
+struct RayBatchResult {
+    std::vector<unsigned char> hit;
+    std::vector<float> tHitNear;
+    std::vector<float> normalX, normalY;
+};
+
+//tests one ray against count rectangles, each one first grown by expand (the moving rectangle's size) around its center,
+//which is the same expansion DynamicRectVSRect does. with expand = {0, 0} it's a plain RayVsRect.
+//maxT rejects hits further along the ray than that, DynamicRectVSRect uses 1.
+//uses AVX when compiled with it (8 at a time), SSE2 otherwise (4 at a time) and plain C++ for what's left over.
+//returns how many rectangles were hit. the hit/t/normal values are exactly what the scalar RayVsRect would produce.
+int RayVsRectBatch(Vector2 ray_origin, Vector2 ray_dir, Vector2 expand, float maxT,
+                   const float* x, const float* y, const float* w, const float* h, int count,
+                   unsigned char* hit, float* tHitNear, float* normalX, float* normalY);
+
+int RayVsRectBatch(Vector2 ray_origin, Vector2 ray_dir, Vector2 expand, float maxT, const RectSoA& rects, RayBatchResult& result);
+
+#endif
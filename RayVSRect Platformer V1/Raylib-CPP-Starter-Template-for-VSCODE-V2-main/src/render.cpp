@@ -0,0 +1,206 @@
+#include "render.h"
+
+#include "rlgl.h"
+#include <math.h>
+#include <algorithm>
+
+//how many quads go into one rlBegin/rlEnd run, small enough to always fit in rlgl's default vertex buffer
+static const int QUADS_PER_RUN = 1024;
+
+void BatchClear(RectBatch& batch){
+    for(auto& list : batch.rects) list.clear();
+}
+
+void BatchAddRect(RectBatch& batch, Rectangle r, Color color){
+    for(int i = 0; i < int(batch.colors.size()); i++){
+        const Color& c = batch.colors[i];
+        if(c.r == color.r && c.g == color.g && c.b == color.b && c.a == color.a){
+            batch.rects[i].push_back(r);
+            return;
+        }
+    }
+    batch.colors.push_back(color);
+    batch.rects.push_back(std::vector<Rectangle> {r});
+}
+
+void BatchSubmit(const RectBatch& batch){
+    for(int i = 0; i < int(batch.colors.size()); i++){
+        const std::vector<Rectangle>& list = batch.rects[i];
+        const Color& c = batch.colors[i];
+
+        for(int start = 0; start < int(list.size()); start += QUADS_PER_RUN){
+            int end = std::min(int(list.size()), start + QUADS_PER_RUN);
+            rlCheckRenderBatchLimit(4*(end - start));
+
+            rlBegin(RL_QUADS);
+            rlColor4ub(c.r, c.g, c.b, c.a);
+            for(int k = start; k < end; k++){
+                const Rectangle& r = list[k];
+                rlVertex2f(r.x, r.y);
+                rlVertex2f(r.x, r.y + r.height);
+                rlVertex2f(r.x + r.width, r.y + r.height);
+                rlVertex2f(r.x + r.width, r.y);
+            }
+            rlEnd();
+        }
+    }
+}
+
+Rectangle CameraWorldRect(Camera2D camera){
+    Vector2 corners[4] = {
+        GetScreenToWorld2D(Vector2 {0, 0}, camera),
+        GetScreenToWorld2D(Vector2 {float(GetScreenWidth()), 0}, camera),
+        GetScreenToWorld2D(Vector2 {0, float(GetScreenHeight())}, camera),
+        GetScreenToWorld2D(Vector2 {float(GetScreenWidth()), float(GetScreenHeight())}, camera)
+    };
+
+    float minX = corners[0].x, maxX = corners[0].x, minY = corners[0].y, maxY = corners[0].y;
+    for(int i = 1; i < 4; i++){
+        minX = std::min(minX, corners[i].x);
+        maxX = std::max(maxX, corners[i].x);
+        minY = std::min(minY, corners[i].y);
+        maxY = std::max(maxY, corners[i].y);
+    }
+    return Rectangle {minX, minY, maxX - minX, maxY - minY};
+}
+
+Color StaticColor(int type){
+    if(type == 0) return YELLOW;
+    if(type == 2) return RED;
+    return WHITE;
+}
+
+static long long TileKey(int tx, int ty){
+    return (long long)(((unsigned long long)(unsigned int)tx << 32) | (unsigned int)ty);
+}
+
+//adds every static overlapping area to the batch, moved by offset
+static void BatchStatics(LevelRenderer& renderer, SimWorld& world, Rectangle area, Vector2 offset){
+    renderer.visible.clear();
+    QueryStatics(world, area, renderer.visible, LAYER_ALL);
+
+    const RectSoA& statics = world.statics;
+    for(int i : renderer.visible){
+        Rectangle r = staticBounds(world, i);
+        if(!rectsOverlap(r, area)) continue;
+        BatchAddRect(renderer.batch, Rectangle {r.x + offset.x, r.y + offset.y, r.width, r.height}, StaticColor(statics.type[i]));
+    }
+}
+
+static void RebuildTile(LevelRenderer& renderer, SimWorld& world, StaticTile& tile, int tx, int ty){
+    float size = renderer.tileWorldSize;
+    Rectangle area = {tx*size, ty*size, size, size};
+
+    BatchClear(renderer.batch);
+    BatchStatics(renderer, world, area, Vector2 {-area.x, -area.y});
+
+    BeginTextureMode(tile.target);
+    ClearBackground(BLANK);
+    BatchSubmit(renderer.batch);
+    EndTextureMode();
+
+    tile.revision = world.levelRevision;
+    tile.drawn = true;
+    renderer.tilesRebuilt++;
+}
+
+//throws away the least recently used tiles until there's room for the ones in view
+static void EvictTiles(LevelRenderer& renderer){
+    while(int(renderer.tiles.size()) > renderer.maxCachedTiles){
+        auto oldest = renderer.tiles.end();
+        for(auto it = renderer.tiles.begin(); it != renderer.tiles.end(); ++it){
+            if(oldest == renderer.tiles.end() || it->second.lastUsed < oldest->second.lastUsed) oldest = it;
+        }
+        if(oldest == renderer.tiles.end() || oldest->second.lastUsed == renderer.frame) break;
+
+        UnloadRenderTexture(oldest->second.target);
+        renderer.tiles.erase(oldest);
+    }
+}
+
+void PrepareLevelRender(LevelRenderer& renderer, SimWorld& world, Camera2D camera){
+    renderer.frame++;
+    renderer.tilesRebuilt = 0;
+    renderer.view = CameraWorldRect(camera);
+
+    float size = renderer.tileWorldSize;
+    renderer.tileX0 = int(floorf(renderer.view.x / size));
+    renderer.tileY0 = int(floorf(renderer.view.y / size));
+    renderer.tileX1 = int(floorf((renderer.view.x + renderer.view.width) / size));
+    renderer.tileY1 = int(floorf((renderer.view.y + renderer.view.height) / size));
+
+    int tileCount = (renderer.tileX1 - renderer.tileX0 + 1) * (renderer.tileY1 - renderer.tileY0 + 1);
+    renderer.cacheThisFrame = tileCount <= renderer.maxCachedTiles;
+    if(!renderer.cacheThisFrame) return;
+
+    for(int ty = renderer.tileY0; ty <= renderer.tileY1; ty++){
+        for(int tx = renderer.tileX0; tx <= renderer.tileX1; tx++){
+            auto it = renderer.tiles.find(TileKey(tx, ty));
+            if(it == renderer.tiles.end()){
+                StaticTile tile {};
+                tile.target = LoadRenderTexture(int(size), int(size));
+                tile.revision = world.levelRevision - 1;
+                it = renderer.tiles.insert({TileKey(tx, ty), tile}).first;
+            }
+
+            it->second.lastUsed = renderer.frame;
+            //an edit only rebuilds the tiles it touched, the rest just catch up to the new revision.
+            //a tile that's never been drawn has nothing to catch up from, so it's always built.
+            StaticTile& tile = it->second;
+            if(!tile.drawn) RebuildTile(renderer, world, tile, tx, ty);
+            else if(tile.revision != world.levelRevision){
+                if(levelChangedSince(world, tile.revision, Rectangle {tx*size, ty*size, size, size})) RebuildTile(renderer, world, tile, tx, ty);
+                else tile.revision = world.levelRevision;
+            }
+        }
+    }
+
+    EvictTiles(renderer);
+}
+
+void DrawLevel(LevelRenderer& renderer, SimWorld& world, const SimClock& clock){
+    renderer.staticsDrawn = 0;
+    renderer.bodiesDrawn = 0;
+
+    if(renderer.cacheThisFrame){
+        float size = renderer.tileWorldSize;
+        for(int ty = renderer.tileY0; ty <= renderer.tileY1; ty++){
+            for(int tx = renderer.tileX0; tx <= renderer.tileX1; tx++){
+                auto it = renderer.tiles.find(TileKey(tx, ty));
+                if(it == renderer.tiles.end()) continue;
+
+                //render textures come out upside down, so the source rectangle is flipped
+                Texture2D texture = it->second.target.texture;
+                DrawTextureRec(texture, Rectangle {0, 0, float(texture.width), -float(texture.height)}, Vector2 {tx*size, ty*size}, WHITE);
+            }
+        }
+        BatchClear(renderer.batch);
+    }
+    else{
+        BatchClear(renderer.batch);
+        BatchStatics(renderer, world, renderer.view, Vector2 {0, 0});
+        renderer.staticsDrawn = int(renderer.visible.size());
+    }
+
+    //moving rectangles get a one pixel expansion to make up for the one-pixel buffer on the player
+    for(int i = 0; i < int(world.bodies.size()); i++){
+        const movingRect& r = world.bodies[i];
+        Vector2 position = InterpolatedPosition(world, clock, i);
+        Rectangle bounds = {position.x, position.y, r.size.x, r.size.y};
+        if(r.type == 0){
+            bounds.width += 1;
+            bounds.height += 1;
+        }
+        if(!rectsOverlap(bounds, renderer.view)) continue;
+
+        BatchAddRect(renderer.batch, bounds, StaticColor(r.type));
+        renderer.bodiesDrawn++;
+    }
+
+    BatchSubmit(renderer.batch);
+}
+
+void UnloadLevelRenderer(LevelRenderer& renderer){
+    for(auto& tile : renderer.tiles) UnloadRenderTexture(tile.second.target);
+    renderer.tiles.clear();
+}
@@ -0,0 +1,65 @@
+#ifndef RENDER_H_
+#define RENDER_H_
+
+#include "raylib.h"
+#include "sim.h"
+#include <unordered_map>
+#include <vector>
+
+//collects rectangles by color and draws all the rectangles of one color in a single rlBegin/rlEnd run,
+//so rlgl can put each color in one draw call instead of going through DrawRectangle for every rectangle.
+struct RectBatch {
+    std::vector<Color> colors;
+    std::vector<std::vector<Rectangle>> rects;
+};
+
+void BatchClear(RectBatch& batch);
+void BatchAddRect(RectBatch& batch, Rectangle r, Color color);
+void BatchSubmit(const RectBatch& batch);
+
+//one square of the level's static geometry, drawn once into a render texture and reused until the level changes
+struct StaticTile {
+    RenderTexture2D target;
+    unsigned int revision;
+    unsigned long long lastUsed;
+    bool drawn;     //false until the first RebuildTile, the texture is empty before that
+};
+
+struct LevelRenderer {
+    //world units covered by one cached tile, and how many tiles can be kept in video memory at once.
+    //when the camera sees more tiles than that (zoomed far out) the statics are drawn directly instead.
+    float tileWorldSize = 1024.0f;
+    int maxCachedTiles = 48;
+
+    std::unordered_map<long long, StaticTile> tiles;
+    unsigned long long frame = 0;
+
+    Rectangle view;
+    bool cacheThisFrame = false;
+    int tileX0, tileY0, tileX1, tileY1;
+
+    RectBatch batch;
+    std::vector<int> visible;
+
+    //how much was drawn last frame, for the debug text
+    int tilesRebuilt = 0;
+    int staticsDrawn = 0;
+    int bodiesDrawn = 0;
+};
+
+//the part of the world the camera can see
+Rectangle CameraWorldRect(Camera2D camera);
+
+Color StaticColor(int type);
+
+//rebuilds any visible cached tiles that are out of date. render textures can't be drawn into while the 2D camera is active,
+//so this has to run before BeginMode2D.
+void PrepareLevelRender(LevelRenderer& renderer, SimWorld& world, Camera2D camera);
+
+//draws the statics and the bodies that are inside the view, call this between BeginMode2D and EndMode2D.
+//the bodies are drawn where the clock says they are between steps, not where the last step left them.
+void DrawLevel(LevelRenderer& renderer, SimWorld& world, const SimClock& clock);
+
+void UnloadLevelRenderer(LevelRenderer& renderer);
+
+#endif
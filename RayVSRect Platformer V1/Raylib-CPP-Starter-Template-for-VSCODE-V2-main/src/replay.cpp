@@ -0,0 +1,197 @@
+#include "replay.h"
+#include "level.h"
+
+#include <cstdio>
+#include <cstring>
+
+enum {
+    REPLAY_LEFT = 1 << 0,
+    REPLAY_RIGHT = 1 << 1,
+    REPLAY_LEFT_PRESSED = 1 << 2,
+    REPLAY_RIGHT_PRESSED = 1 << 3,
+    REPLAY_CROUCH = 1 << 4,
+    REPLAY_CROUCH_PRESSED = 1 << 5,
+    REPLAY_JUMP_PRESSED = 1 << 6,
+    REPLAY_JUMP_HELD = 1 << 7,
+    REPLAY_RESPAWN = 1 << 8,
+};
+
+unsigned short ReplayPackInput(const SimInput& input){
+    unsigned short controls = 0;
+    if(input.left) controls |= REPLAY_LEFT;
+    if(input.right) controls |= REPLAY_RIGHT;
+    if(input.leftPressed) controls |= REPLAY_LEFT_PRESSED;
+    if(input.rightPressed) controls |= REPLAY_RIGHT_PRESSED;
+    if(input.crouch) controls |= REPLAY_CROUCH;
+    if(input.crouchPressed) controls |= REPLAY_CROUCH_PRESSED;
+    if(input.jumpPressed) controls |= REPLAY_JUMP_PRESSED;
+    if(input.jumpHeld) controls |= REPLAY_JUMP_HELD;
+    if(input.respawn) controls |= REPLAY_RESPAWN;
+    return controls;
+}
+
+SimInput ReplayUnpackInput(unsigned short controls){
+    SimInput input = {};
+    input.left = controls & REPLAY_LEFT;
+    input.right = controls & REPLAY_RIGHT;
+    input.leftPressed = controls & REPLAY_LEFT_PRESSED;
+    input.rightPressed = controls & REPLAY_RIGHT_PRESSED;
+    input.crouch = controls & REPLAY_CROUCH;
+    input.crouchPressed = controls & REPLAY_CROUCH_PRESSED;
+    input.jumpPressed = controls & REPLAY_JUMP_PRESSED;
+    input.jumpHeld = controls & REPLAY_JUMP_HELD;
+    input.respawn = controls & REPLAY_RESPAWN;
+    return input;
+}
+
+//fnv-1a over the raw bytes, so two states only match if every float matches bit for bit
+static void HashBytes(unsigned long long& hash, const void* data, size_t size){
+    const unsigned char* bytes = (const unsigned char*)data;
+    for(size_t i = 0; i < size; i++){
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+}
+
+unsigned long long SimStateHash(const SimWorld& world){
+    unsigned long long hash = 14695981039346656037ull;
+    for(const movingRect& body : world.bodies){
+        HashBytes(hash, &body.position, sizeof(body.position));
+        HashBytes(hash, &body.velocity, sizeof(body.velocity));
+        HashBytes(hash, &body.size, sizeof(body.size));
+    }
+    HashBytes(hash, &world.time, sizeof(world.time));
+    bool flags[] = {world.grounded, world.jumping, world.crouching, world.sliding, world.wallslidingLeft, world.wallslidingRight};
+    HashBytes(hash, flags, sizeof(flags));
+    float timers[] = {world.groundedCoyoteTimer, world.wallslideLeftCoyoteTimer, world.wallslideRightCoyoteTimer,
+                      world.bufferJumpTimer, world.noControlTimer, world.brakingConstant, world.gravityModifier};
+    HashBytes(hash, timers, sizeof(timers));
+    return hash;
+}
+
+void ReplayRestart(const Replay& replay, SimWorld& world, SimClock& clock){
+    //a fresh world, so tuning values and timers the last session changed don't leak into the replay.
+    //the level revision keeps counting up so anything caching the old level sees it changed.
+    JobSystem* jobs = world.jobs;
+    unsigned int revision = world.levelRevision;
+    world = SimWorld();
+    world.jobs = jobs;
+    world.levelRevision = revision;
+    loadLevelMemory(world, replay.level.data(), replay.level.size());
+
+    for(const ReplayBody& b : replay.bodies){
+        movingRect body {};
+        body.position = Vector2 {b.x, b.y};
+        body.size = Vector2 {b.w, b.h};
+        body.type = b.type;
+        body.mass = b.mass;
+        body.velocity = Vector2 {b.velX, b.velY};
+        world.bodies.push_back(body);
+    }
+
+    clock = SimClock();
+    clock.stepDt = replay.stepDt;
+    clock.maxSteps = replay.maxSteps;
+}
+
+void ReplayBegin(Replay& replay, SimWorld& world, SimClock& clock){
+    encodeLevelBinary(world, replay.level);
+    replay.bodies.clear();
+    for(int i = 0; i < int(world.bodies.size()); i++){
+        if(i == world.playerBody) continue;
+        const movingRect& b = world.bodies[i];
+        replay.bodies.push_back(ReplayBody {b.position.x, b.position.y, b.size.x, b.size.y, b.type, b.mass, b.velocity.x, b.velocity.y});
+    }
+    replay.frames.clear();
+    replay.stepDt = clock.stepDt;
+    replay.maxSteps = clock.maxSteps;
+    replay.finalHash = 0;
+
+    ReplayRestart(replay, world, clock);
+    replay.recording = true;
+    replay.startRevision = world.levelRevision;
+    replay.startBodies = world.bodies.size();
+}
+
+bool ReplayRecordFrame(Replay& replay, const SimWorld& world, const SimInput& input, float frameTime){
+    if(!replay.recording) return false;
+    if(world.levelRevision != replay.startRevision || world.bodies.size() != replay.startBodies){
+        replay.recording = false;
+        return false;
+    }
+    replay.frames.push_back(ReplayFrame {frameTime, ReplayPackInput(input)});
+    return true;
+}
+
+bool ReplayEnd(Replay& replay, const SimWorld& world, const char* fileName){
+    replay.recording = false;
+    replay.finalHash = SimStateHash(world);
+    return ReplaySave(replay, fileName);
+}
+
+bool ReplaySave(const Replay& replay, const char* fileName){
+    ReplayHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, REPLAY_FILE_MAGIC, 4);
+    header.version = REPLAY_FILE_VERSION;
+    header.stepDt = replay.stepDt;
+    header.maxSteps = replay.maxSteps;
+    header.frameCount = unsigned(replay.frames.size());
+    header.levelSize = unsigned(replay.level.size());
+    header.bodyCount = unsigned(replay.bodies.size());
+    header.finalHash = replay.finalHash;
+
+    FILE* file = fopen(fileName, "wb");
+    if(file == NULL) return false;
+
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    if(!replay.level.empty()) ok = ok && fwrite(replay.level.data(), 1, replay.level.size(), file) == replay.level.size();
+    if(!replay.bodies.empty()) ok = ok && fwrite(replay.bodies.data(), sizeof(ReplayBody), replay.bodies.size(), file) == replay.bodies.size();
+
+    //6 bytes a frame instead of the struct's padded 8
+    for(const ReplayFrame& frame : replay.frames){
+        ok = ok && fwrite(&frame.frameTime, sizeof(float), 1, file) == 1;
+        ok = ok && fwrite(&frame.controls, sizeof(unsigned short), 1, file) == 1;
+    }
+    return fclose(file) == 0 && ok;
+}
+
+bool ReplayLoad(Replay& replay, const char* fileName){
+    FILE* file = fopen(fileName, "rb");
+    if(file == NULL){
+        fprintf(stderr, "could not open replay %s\n", fileName);
+        return false;
+    }
+
+    ReplayHeader header;
+    if(fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, REPLAY_FILE_MAGIC, 4) != 0){
+        fprintf(stderr, "%s is not a replay\n", fileName);
+        fclose(file);
+        return false;
+    }
+    if(header.version != REPLAY_FILE_VERSION){
+        fprintf(stderr, "replay version %u is not supported\n", header.version);
+        fclose(file);
+        return false;
+    }
+
+    replay.stepDt = header.stepDt;
+    replay.maxSteps = header.maxSteps;
+    replay.finalHash = header.finalHash;
+    replay.recording = false;
+
+    replay.level.resize(header.levelSize);
+    replay.bodies.resize(header.bodyCount);
+    replay.frames.resize(header.frameCount);
+    bool ok = true;
+    if(header.levelSize > 0) ok = fread(replay.level.data(), 1, header.levelSize, file) == header.levelSize;
+    if(ok && header.bodyCount > 0) ok = fread(replay.bodies.data(), sizeof(ReplayBody), header.bodyCount, file) == header.bodyCount;
+    for(ReplayFrame& frame : replay.frames){
+        if(!ok) break;
+        ok = fread(&frame.frameTime, sizeof(float), 1, file) == 1 && fread(&frame.controls, sizeof(unsigned short), 1, file) == 1;
+    }
+    if(!ok) fprintf(stderr, "replay %s is truncated\n", fileName);
+
+    fclose(file);
+    return ok;
+}
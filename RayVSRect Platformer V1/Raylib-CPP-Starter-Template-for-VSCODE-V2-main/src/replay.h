@@ -0,0 +1,79 @@
+#ifndef REPLAY_H_
+#define REPLAY_H_
+
+//recording a session's controls and frame times so it can be played back exactly, with or without a window.
+//the simulation only depends on the level, the controls and the frame times fed to SimAdvance (no GetTime(), no random),
+//so a replay is the level and bodies it started from plus one small record per frame.
+//recording restarts the world from what it captured, so the live session and every playback start from the same state.
+//editing the level or adding bodies while recording isn't captured, so it stops the recording.
+
+#include "sim.h"
+#include <vector>
+
+//a .rvr file: a ReplayHeader, levelSize bytes of binary level (see encodeLevelBinary), bodyCount ReplayBodys for
+//the bodies other than the player, then frameCount frames of a float frame time followed by a 16 bit control mask.
+#define REPLAY_FILE_MAGIC "RVRP"
+#define REPLAY_FILE_VERSION 1u
+
+struct ReplayHeader {
+    char magic[4];
+    unsigned int version;
+    float stepDt;
+    int maxSteps;
+    unsigned int frameCount;
+    unsigned int levelSize;
+    unsigned int bodyCount;
+    unsigned int pad;
+    //SimStateHash at the end of the recording, playback compares against it
+    unsigned long long finalHash;
+};
+
+struct ReplayBody {
+    float x, y, w, h;
+    int type;
+    float mass;
+    float velX, velY;
+};
+
+struct ReplayFrame {
+    float frameTime;
+    unsigned short controls;   //SimInput packed by ReplayPackInput
+};
+
+struct Replay {
+    std::vector<unsigned char> level;
+    std::vector<ReplayBody> bodies;
+    std::vector<ReplayFrame> frames;
+    float stepDt = 1.0f / 120.0f;
+    int maxSteps = 8;
+    unsigned long long finalHash = 0;
+
+    //while recording
+    bool recording = false;
+    unsigned int startRevision = 0;
+    size_t startBodies = 0;
+};
+
+unsigned short ReplayPackInput(const SimInput& input);
+SimInput ReplayUnpackInput(unsigned short controls);
+
+//a hash of everything that moves (bodies, the player's state flags and the clock), for checking a playback matched
+unsigned long long SimStateHash(const SimWorld& world);
+
+//captures the level and the bodies, then restarts world and clock from the capture and starts recording
+void ReplayBegin(Replay& replay, SimWorld& world, SimClock& clock);
+
+//call once a frame with exactly what's about to go into SimAdvance. returns false (and stops recording)
+//if the world was edited since ReplayBegin, since the replay couldn't reproduce that.
+bool ReplayRecordFrame(Replay& replay, const SimWorld& world, const SimInput& input, float frameTime);
+
+//stops recording and writes the replay
+bool ReplayEnd(Replay& replay, const SimWorld& world, const char* fileName);
+
+bool ReplaySave(const Replay& replay, const char* fileName);
+bool ReplayLoad(Replay& replay, const char* fileName);
+
+//puts the world and clock back to where the replay started. the world's job system is kept.
+void ReplayRestart(const Replay& replay, SimWorld& world, SimClock& clock);
+
+#endif
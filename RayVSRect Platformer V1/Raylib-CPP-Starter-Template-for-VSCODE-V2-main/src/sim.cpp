@@ -0,0 +1,806 @@
+#include "sim.h"
+#include "raybatch.h"
+#include "profile.h"
+
+#include <raymath.h>
+#include <math.h>
+#include <algorithm>
+
+const ray zeroRay = {0, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+
+float sign(float in){
+    if(in < 0) return -1;
+    if(in > 0) return 1;
+    return 0;
+}
+
+
+ray RayVsRect(const Vector2& ray_origin, const Vector2& ray_dir, const Vector2& r_position, const Vector2& r_size, int r_type){
+
+Vector2 t_near = Vector2Divide((Vector2Subtract(r_position, ray_origin)), ray_dir);
+Vector2 t_far =  Vector2Divide(Vector2Add(r_position, Vector2Subtract(r_size, ray_origin)), ray_dir);
+
+if(std::isnan(t_far.y) || std::isnan(t_far.x)) return zeroRay;
+if(std::isnan(t_near.y) || std::isnan(t_near.x)) return zeroRay;
+
+if(t_near.x > t_far.x) std::swap(t_near.x, t_far.x);
+if(t_near.y > t_far.y) std::swap(t_near.y, t_far.y);
+
+if(t_near.x > t_far.y || t_near.y > t_far.x) return zeroRay;
+
+float t_hit_near = std::max(t_near.x, t_near.y);
+float t_hit_far = std::min(t_far.x, t_far.y);
+
+if (t_hit_far < 0) return zeroRay;
+
+Vector2 contact_point = Vector2 {std::round(Vector2Add(ray_origin, Vector2Multiply(Vector2 {t_hit_near, t_hit_near}, ray_dir)).x), std::round(Vector2Add(ray_origin, Vector2Multiply(Vector2 {t_hit_near, t_hit_near}, ray_dir)).y)};
+Vector2 contact_normal = {0, 0};
+
+if(t_near.x > t_near.y){
+    if(ray_dir.x < 0) contact_normal = {1, 0};
+    else contact_normal = {-1, 0};
+}
+else if (t_near.x < t_near.y){
+    if (ray_dir.y < 0) contact_normal = {0, 1};
+    else contact_normal = {0, -1};
+}
+return ray {1, contact_point, contact_normal, t_hit_near, r_type};
+}
+
+ray RayVsRect(const Vector2& ray_origin, const Vector2& ray_dir, const movingRect& r){
+    return RayVsRect(ray_origin, ray_dir, r.position, r.size, r.type);
+}
+
+ray DynamicRectVSRect(const movingRect& in, const Vector2& target_position, const Vector2& target_size, int target_type, float dt){
+    if(in.velocity.x == 0 && in.velocity.y == 0) return zeroRay;
+
+    Vector2 expanded_position = {target_position.x - in.size.x/2, target_position.y - in.size.y/2};
+    Vector2 expanded_size = {target_size.x + in.size.x, target_size.y + in.size.y};
+
+    Vector2 inCenter = {in.position.x + in.size.x/2, in.position.y + in.size.y/2};
+
+    ray RectRay = RayVsRect(inCenter, Vector2{in.velocity.x*dt, in.velocity.y*dt}, expanded_position, expanded_size, target_type);
+    if(RectRay.collided && RectRay.rayCheck <= 1.0f) {
+        return RectRay;
+    }
+    else return zeroRay;
+    }
+
+ray DynamicRectVSRect(const movingRect& in, const movingRect& target, float dt){
+    return DynamicRectVSRect(in, target.position, target.size, target.type, dt);
+}
+
+void ClipVelocity(movingRect& r, const ray& hit){
+    r.velocity = Vector2Add(Vector2Add(r.velocity, Vector2{hit.contact_normal.x, hit.contact_normal.y}), Vector2Multiply(hit.contact_normal, Vector2Scale((Vector2){fabsf(r.velocity.x), fabsf(r.velocity.y)}, (1-hit.rayCheck))));
+}
+
+int SlideAlong(movingRect& r, Vector2 castVelocity, const ray& firstHit, const RectSoA& rects, RayBatchResult& hits, float dt,
+               int passes, int& budget, TOIStats& stats, const std::function<void(int k, const ray& hit)>& touched){
+    //the clipped velocity takes the mover's center from start to end in a straight line, which cuts the corner the slide
+    //should go around. the path it really takes is to the first contact along the velocity it was cast with, then along
+    //the surface to end, and it's that second leg that gets swept.
+    //every leg starts a pixel per second off the surface it left, the same gap ClipVelocity leaves, so it isn't cast
+    //from right on the edge of the rectangle next to it along a row of tiles.
+    if(passes <= 1) return 0;
+    Vector2 start = {r.position.x + r.size.x/2, r.position.y + r.size.y/2};
+    Vector2 from = Vector2Add(Vector2Add(start, Vector2Scale(castVelocity, dt*std::max(firstHit.rayCheck, 0.0f))), Vector2Scale(firstHit.contact_normal, dt));
+    Vector2 end = Vector2Add(start, Vector2Scale(r.velocity, dt));
+
+    int sweeps = 0;
+    bool moved = false;
+    for(int pass = 1;; pass++){
+        Vector2 leg = Vector2Subtract(end, from);
+        if(leg.x == 0 && leg.y == 0) break;
+        if(budget <= 0){
+            stats.outOfBudget++;
+            break;
+        }
+        budget--;
+        sweeps++;
+        if(RayVsRectBatch(from, leg, r.size, 1.0f, rects, hits) == 0) break;
+
+        //only rectangles ahead that the leg is heading into count. one it's already overlapping is the first sweep's to sort out.
+        int nearest = -1;
+        for(int k = 0; k < SoACount(rects); k++){
+            if(!hits.hit[k] || hits.tHitNear[k] < 0 || hits.normalX[k]*leg.x + hits.normalY[k]*leg.y >= 0) continue;
+            if(nearest < 0 || hits.tHitNear[k] < hits.tHitNear[nearest]) nearest = k;
+        }
+        if(nearest < 0) break;
+
+        float t = hits.tHitNear[nearest];
+        Vector2 n = {hits.normalX[nearest], hits.normalY[nearest]};
+        ray hit = {1, Vector2 {std::round(from.x + t*leg.x), std::round(from.y + t*leg.y)}, n, t, rects.type[nearest]};
+        touched(nearest, hit);
+        if(pass == 1) stats.movers++;
+
+        from = Vector2Add(Vector2Add(from, Vector2Scale(leg, t)), Vector2Scale(n, dt));
+        moved = true;
+        if(pass + 1 < passes){
+            //what's left of the leg, less the part going into the surface
+            Vector2 rest = Vector2Scale(leg, 1 - t);
+            rest = Vector2Subtract(rest, Vector2Scale(n, Vector2DotProduct(rest, n)));
+            end = Vector2Add(from, rest);
+        }
+        else{
+            //out of passes, so it goes no further than this contact
+            end = from;
+            stats.capped++;
+            break;
+        }
+    }
+
+    //the position is still integrated from the velocity, so it's whatever covers start to end in one step
+    if(moved) r.velocity = Vector2Scale(Vector2Subtract(end, start), 1/dt);
+
+    stats.sweeps += sweeps;
+    stats.mostSweeps = std::max(stats.mostSweeps, sweeps + 1);
+    return sweeps;
+}
+
+Rectangle rectBounds(const movingRect& r){
+    return Rectangle {r.position.x, r.position.y, r.size.x, r.size.y};
+}
+
+Rectangle sweptBounds(const movingRect& r, float dt){
+    Vector2 step = {r.velocity.x*dt, r.velocity.y*dt};
+    Rectangle area;
+    area.x = std::min(r.position.x, r.position.x + step.x) - 1;
+    area.y = std::min(r.position.y, r.position.y + step.y) - 1;
+    area.width = r.size.x + fabsf(step.x) + 2;
+    area.height = r.size.y + fabsf(step.y) + 2;
+    return area;
+}
+
+bool rectsOverlap(Rectangle a, Rectangle b){
+    return a.x <= b.x + b.width && b.x <= a.x + a.width && a.y <= b.y + b.height && b.y <= a.y + a.height;
+}
+
+bool rectsIntersect(Rectangle a, Rectangle b){
+    return a.x < b.x + b.width && b.x < a.x + a.width && a.y < b.y + b.height && b.y < a.y + a.height;
+}
+
+bool sweptIntersects(Rectangle r, Vector2 move, Rectangle target){
+    //r's center against target grown by half of r on each side, so it's a segment against a box.
+    //the box is open on both ends, like rectsIntersect, so only passing through its inside counts.
+    float origin[2] = {r.x + r.width/2, r.y + r.height/2};
+    float dir[2] = {move.x, move.y};
+    float lo[2] = {target.x - r.width/2, target.y - r.height/2};
+    float hi[2] = {target.x + target.width + r.width/2, target.y + target.height + r.height/2};
+
+    float tEnter = 0, tExit = 1;
+    for(int axis = 0; axis < 2; axis++){
+        if(dir[axis] == 0){
+            if(origin[axis] <= lo[axis] || origin[axis] >= hi[axis]) return false;
+            continue;
+        }
+        float t0 = (lo[axis] - origin[axis]) / dir[axis];
+        float t1 = (hi[axis] - origin[axis]) / dir[axis];
+        if(t0 > t1) std::swap(t0, t1);
+        tEnter = std::max(tEnter, t0);
+        tExit = std::min(tExit, t1);
+    }
+    return tEnter < tExit;
+}
+
+static bool isSolidStatic(const SimWorld& world, int i){
+    return (StaticLayer(world, world.statics.type[i]) & LAYER_SOLID) != 0;
+}
+
+static SpatialGrid& staticGrid(SimWorld& world, int i){
+    return isSolidStatic(world, i) ? world.levelGrid : world.triggerGrid;
+}
+
+static AABBTree& staticTree(SimWorld& world, int i){
+    return isSolidStatic(world, i) ? world.levelTree : world.triggerTree;
+}
+
+//puts statics[i] in its layer's grid or tree depending on its size
+static void indexStatic(SimWorld& world, int i){
+    Rectangle bounds = staticBounds(world, i);
+    if(bounds.width > world.treeMinSize || bounds.height > world.treeMinSize){
+        world.staticProxy[i] = TreeInsert(staticTree(world, i), i, bounds);
+    }
+    else{
+        world.staticProxy[i] = -1;
+        GridInsert(staticGrid(world, i), i, bounds);
+    }
+}
+
+static void unindexStatic(SimWorld& world, int i){
+    if(world.staticProxy[i] >= 0) TreeRemove(staticTree(world, i), world.staticProxy[i]);
+    else GridRemove(staticGrid(world, i), i, staticBounds(world, i));
+}
+
+void addStatic(SimWorld& world, float x, float y, float w, float h, int type){
+    SoAPush(world.statics, x, y, w, h, (unsigned char)type);
+    world.staticOwner.push_back(-1);
+    world.staticProxy.push_back(-1);
+    indexStatic(world, SoACount(world.statics) - 1);
+    markLevelChanged(world, Rectangle {x, y, w, h});
+}
+
+void removeStatic(SimWorld& world, int i){
+    RectSoA& statics = world.statics;
+    if(i < 0 || i >= SoACount(statics)) return;
+
+    int last = SoACount(statics) - 1;
+    markLevelChanged(world, staticBounds(world, i));
+    unindexStatic(world, i);
+    TilesStaticMoved(world, i, -1);
+    if(i != last){
+        //a leaf in the tree just gets its id changed, a grid entry has to be taken out and put back under the new index
+        int proxy = world.staticProxy[last];
+        if(proxy < 0) GridRemove(staticGrid(world, last), last, staticBounds(world, last));
+        statics.x[i] = statics.x[last];
+        statics.y[i] = statics.y[last];
+        statics.w[i] = statics.w[last];
+        statics.h[i] = statics.h[last];
+        statics.type[i] = statics.type[last];
+        TilesStaticMoved(world, last, i);
+        world.staticOwner[i] = world.staticOwner[last];
+        world.staticProxy[i] = proxy;
+        if(proxy >= 0) TreeSetId(staticTree(world, i), proxy, i);
+        else GridInsert(staticGrid(world, i), i, staticBounds(world, i));
+    }
+    statics.x.pop_back();
+    statics.y.pop_back();
+    statics.w.pop_back();
+    statics.h.pop_back();
+    statics.type.pop_back();
+    world.staticOwner.pop_back();
+    world.staticProxy.pop_back();
+}
+
+//the area used for changes that touch the whole level
+static const Rectangle everywhere = {-1e30f, -1e30f, 2e30f, 2e30f};
+
+void clearLevel(SimWorld& world){
+    SoAClear(world.statics);
+    world.staticOwner.clear();
+    world.staticProxy.clear();
+    ClearTiles(world);
+    world.bodies.clear();
+    world.playerBody = 0;
+    world.contacts.contacts.clear();
+    WakeAllBodies(world);
+    GridInit(world.levelGrid, world.tileSize);
+    TreeClear(world.levelTree);
+    GridInit(world.triggerGrid, world.tileSize);
+    TreeClear(world.triggerTree);
+    markLevelChanged(world, everywhere);
+}
+
+void rebuildLevelGrid(SimWorld& world){
+    world.staticOwner.resize(SoACount(world.statics), -1);
+    GridInit(world.levelGrid, world.tileSize);
+    TreeClear(world.levelTree);
+    GridInit(world.triggerGrid, world.tileSize);
+    TreeClear(world.triggerTree);
+    world.staticProxy.assign(SoACount(world.statics), -1);
+    for(int i = 0; i < SoACount(world.statics); i++) indexStatic(world, i);
+    markLevelChanged(world, everywhere);
+}
+
+void swapLevel(SimWorld& world, SimWorld& other){
+    std::swap(world.statics, other.statics);
+    std::swap(world.staticOwner, other.staticOwner);
+    std::swap(world.tiles, other.tiles);
+    std::swap(world.bodies, other.bodies);
+    std::swap(world.playerBody, other.playerBody);
+    std::swap(world.levelGrid, other.levelGrid);
+    std::swap(world.levelTree, other.levelTree);
+    std::swap(world.triggerGrid, other.triggerGrid);
+    std::swap(world.triggerTree, other.triggerTree);
+    std::swap(world.typeLayer, other.typeLayer);
+    std::swap(world.staticProxy, other.staticProxy);
+    std::swap(world.tileSize, other.tileSize);
+    std::swap(world.treeMinSize, other.treeMinSize);
+    world.contacts.contacts.clear();
+    WakeAllBodies(world);
+    markLevelChanged(world, everywhere);
+}
+
+void QueryStatics(SimWorld& world, Rectangle area, std::vector<int>& out, unsigned int layers){
+    if(layers & LAYER_SOLID){
+        GridQuery(world.levelGrid, area, out);
+        TreeQuery(world.levelTree, area, out);
+    }
+    if(layers & ~(unsigned int)LAYER_SOLID){
+        size_t first = out.size();
+        GridQuery(world.triggerGrid, area, out);
+        TreeQuery(world.triggerTree, area, out);
+        //hazards and triggers share their grid and tree, so the ones on layers nobody asked for come out here
+        out.erase(std::remove_if(out.begin() + first, out.end(), [&](int i){
+            return (StaticLayer(world, world.statics.type[i]) & layers) == 0;
+        }), out.end());
+    }
+}
+
+void QueryStaticsShared(const SimWorld& world, Rectangle area, std::vector<int>& out, unsigned int layers){
+    if(layers & LAYER_SOLID){
+        GridQueryShared(world.levelGrid, area, out);
+        TreeQuery(world.levelTree, area, out);
+    }
+    if(layers & ~(unsigned int)LAYER_SOLID){
+        size_t first = out.size();
+        GridQueryShared(world.triggerGrid, area, out);
+        TreeQuery(world.triggerTree, area, out);
+        out.erase(std::remove_if(out.begin() + first, out.end(), [&](int i){
+            return (StaticLayer(world, world.statics.type[i]) & layers) == 0;
+        }), out.end());
+    }
+}
+
+void RaycastStatics(const SimWorld& world, Vector2 origin, Vector2 dir, std::vector<int>& out, unsigned int layers){
+    if(layers & LAYER_SOLID){
+        GridRaycast(world.levelGrid, origin, dir, 1.0f, out);
+        TreeRaycast(world.levelTree, origin, dir, 1.0f, out);
+    }
+    if(layers & ~(unsigned int)LAYER_SOLID){
+        size_t first = out.size();
+        GridRaycast(world.triggerGrid, origin, dir, 1.0f, out);
+        TreeRaycast(world.triggerTree, origin, dir, 1.0f, out);
+        out.erase(std::remove_if(out.begin() + first, out.end(), [&](int i){
+            return (StaticLayer(world, world.statics.type[i]) & layers) == 0;
+        }), out.end());
+    }
+}
+
+static bool rectContains(Rectangle outer, Rectangle inner){
+    return inner.x >= outer.x && inner.y >= outer.y &&
+           inner.x + inner.width <= outer.x + outer.width && inner.y + inner.height <= outer.y + outer.height;
+}
+
+void markLevelChanged(SimWorld& world, Rectangle area){
+    world.levelRevision++;
+    if(world.levelChanges.empty()) world.levelChanges.resize(LEVEL_CHANGE_HISTORY, LevelChange {0, 0, everywhere});
+
+    //whole-level changes are never extended, or everything after a load would count as part of it
+    LevelChange& newest = world.levelChanges[world.newestChange];
+    bool wholeLevel = newest.area.width >= everywhere.width;
+    if(!wholeLevel && newest.lastRevision == world.levelRevision - 1 && rectContains(newest.area, area)){
+        newest.lastRevision = world.levelRevision;
+        return;
+    }
+
+    world.newestChange = (world.newestChange + 1) % LEVEL_CHANGE_HISTORY;
+    world.levelChanges[world.newestChange] = LevelChange {world.levelRevision, world.levelRevision, area};
+}
+
+bool levelChangedSince(const SimWorld& world, unsigned int revision, Rectangle area){
+    if(world.levelRevision == revision) return false;
+    if(world.levelChanges.empty()) return true;
+
+    //walks back from the newest change until every revision after the given one has been looked at
+    for(int k = 0; k < LEVEL_CHANGE_HISTORY; k++){
+        const LevelChange& change = world.levelChanges[(world.newestChange - k + LEVEL_CHANGE_HISTORY) % LEVEL_CHANGE_HISTORY];
+        if(change.lastRevision == 0) return true;
+        if(rectsOverlap(change.area, area)) return true;
+        if(change.firstRevision <= revision + 1) return false;
+    }
+
+    //older than anything that's still remembered
+    return true;
+}
+
+void applyForce(SimWorld& world, float fx, float fy){
+
+SimPlayer(world).force = Vector2Add(SimPlayer(world).force, Vector2 {fx, fy});
+
+}
+
+void playerDeath(SimWorld& world) {
+movingRect& player = SimPlayer(world);
+player.position = world.playerSpawn;
+player.velocity = Vector2{0,0};
+ContactsForget(world.contacts, world.playerBody);
+}
+
+void playerJump(SimWorld& world) {
+movingRect& player = SimPlayer(world);
+
+//walljump logic
+    if(!world.grounded)
+    {
+        if(world.wallslidingRight || world.time < world.wallslideRightCoyoteTimer)
+        {
+        world.controlsEnabled = 0;
+        player.velocity.y = -world.wallJumpVel;
+        player.velocity.x = -world.pushoffVel;
+        world.noControlTimer = world.time;
+        world.jumping = 1;
+        world.wallslidingRight = 0;
+        world.wallslideRightCoyoteTimer = 0;
+        }
+
+        else if (world.wallslidingLeft || world.time < world.wallslideLeftCoyoteTimer)
+        {
+        world.controlsEnabled = 0;
+        player.velocity.y = -world.wallJumpVel;
+        player.velocity.x = world.pushoffVel;
+        world.noControlTimer = world.time;
+        world.jumping = 1;
+        world.wallslidingLeft = 0;
+        world.wallslideLeftCoyoteTimer = 0;
+        }
+
+    else{
+    world.bufferJumpTimer = world.time;
+        }
+    }
+
+
+
+    if((world.grounded) || world.time < world.groundedCoyoteTimer ){
+
+        if(world.sliding){
+            world.brakingConstant = 0;
+            player.velocity.x = sign(player.velocity.x) * 600;
+            player.velocity.y = -world.jumpVel;
+            world.grounded = 0;
+            world.jumping = 1;
+        }
+
+        else{
+    player.velocity.y = -world.jumpVel;
+    world.grounded = 0;
+    world.jumping = 1;
+        }
+    }
+
+}
+
+//turns the controls into forces and velocity changes on the player, this used to live in GetInput()
+static void ApplyInput(SimWorld& world, const SimInput& input){
+movingRect& player = SimPlayer(world);
+
+player.force = Vector2 {0, 0};
+
+if(world.time <= world.noControlTimer + world.noControlWindow && world.time >= world.noControlTimer){
+    world.controlsEnabled = 0;
+}
+else{
+    world.controlsEnabled = 1;
+}
+
+if(world.controlsEnabled){
+
+if(input.respawn){
+    playerDeath(world);
+}
+
+//JUMP LOGIC
+if(input.jumpPressed){
+    playerJump(world);
+}
+
+if((world.grounded || world.wallslidingLeft || world.wallslidingRight) && world.time <= world.bufferJumpTimer + world.bufferWindow && world.time >= world.bufferJumpTimer){
+playerJump(world);
+world.bufferJumpTimer = 0;
+}
+
+    if(!input.jumpHeld && world.jumping){
+       //if player is moving up, double the force of gravity until they're not moving up, then apply normal gravity
+        if(player.velocity.y < 0){
+        world.gravityModifier = 2.0;
+        }
+
+    }
+else {
+    world.gravityModifier = 1;
+}
+    if(player.velocity.y >= 0){
+            world.gravityModifier = 1;
+        }
+
+    if(world.grounded){
+        world.jumping = false;
+        world.gravityModifier = 1;
+        }
+//END JUMP LOGIC
+
+//movement logic
+float targetSpeed = 0;
+
+
+if(!world.crouching){
+if(input.left){
+    targetSpeed = -world.playerSpeed;
+    float speedDif = player.velocity.x - targetSpeed;
+    float movement = -(speedDif*world.accConstant);
+    applyForce(world, movement, 0);
+}
+else if (input.right){
+    targetSpeed = world.playerSpeed;
+    float speedDif = player.velocity.x - targetSpeed;
+    float movement = -speedDif*world.accConstant;
+    applyForce(world, movement, 0);
+}
+else{
+    targetSpeed = 0;
+    float speedDif = -player.velocity.x;
+    float movement = speedDif*world.brakingConstant;
+    applyForce(world, movement, 0);
+}
+}
+
+//crouched movement logic
+else if(world.crouching && world.grounded){
+    if(input.leftPressed)
+{
+    player.velocity.x += -world.slideSpeed;
+    world.sliding = 1;
+}
+else if (input.rightPressed)
+{
+    player.velocity.x += world.slideSpeed;
+    world.sliding = 1;
+}
+else
+{
+    targetSpeed = 0;
+    float speedDif = -player.velocity.x;
+    float movement = speedDif*world.brakingConstant/3;
+    applyForce(world, movement, 0);
+}
+    }
+
+
+}
+
+if(input.crouchPressed && world.grounded){
+    player.position.y += (player.size.y - world.crouchHeight);
+    player.size.y = world.crouchHeight;
+}
+if(input.crouch){
+
+    if(world.grounded){
+        world.crouching = 1;
+        player.size.y = world.crouchHeight;
+    }
+
+}
+
+if(!input.crouch && world.crouching){
+    world.crouching = 0;
+    world.sliding = 0;
+    player.position.y += -(world.playerHeight - world.crouchHeight);
+    player.size.y = world.playerHeight;
+}
+
+//a = f/m
+player.acc.y = (world.gravity*world.gravityModifier) + (player.force.y/player.mass);
+player.acc.x = player.force.x/player.mass;
+
+}
+
+//integrates the player, sweeps it against the level and resolves the collisions, this used to be RunLogic()
+static void StepPhysics(SimWorld& world, float dt){
+const RectSoA& statics = world.statics;
+movingRect& player = SimPlayer(world);
+
+player.velocity.x += player.acc.x * dt;
+player.velocity.y += player.acc.y * dt;
+
+std::vector<collision> z;
+
+//surfaces the player was already resting on last step are clipped against first and left out of the sweep
+std::vector<int>& resting = world.stepResting;
+resting.clear();
+ContactsBeginStep(world.contacts, world.playerBody);
+ContactsWarmStart(world, world.playerBody, dt, resting);
+
+//broadphase: only the rectangles near the area the player sweeps through this step (by grid cell, or by tree box for big ones) can be hit.
+//the candidates are sorted so they're tested in the same order as a full pass over the statics would test them.
+std::vector<int>& candidates = world.stepCandidates;
+candidates.clear();
+{
+PROFILE_SCOPE("broadphase");
+QueryStatics(world, sweptBounds(player, dt), candidates, world.playerCollidesWith);
+std::sort(candidates.begin(), candidates.end());
+if(!resting.empty()){
+    candidates.erase(std::remove_if(candidates.begin(), candidates.end(), [&](int i){
+        return std::find(resting.begin(), resting.end(), i) != resting.end();
+    }), candidates.end());
+}
+}
+
+//narrowphase: the candidates are copied into structure-of-arrays form and swept against in one batched call,
+//which gives the same results as calling DynamicRectVSRect on each of them.
+RectSoA& candidateRects = world.stepCandidateRects;
+RayBatchResult& candidateHits = world.stepCandidateHits;
+{
+PROFILE_SCOPE("narrowphase");
+SoAClear(candidateRects);
+for(int i : candidates){
+    SoAPush(candidateRects, statics.x[i], statics.y[i], statics.w[i], statics.h[i], statics.type[i]);
+}
+
+if(!(player.velocity.x == 0 && player.velocity.y == 0)){
+    Vector2 inCenter = {player.position.x + player.size.x/2, player.position.y + player.size.y/2};
+    Vector2 rayDir = {player.velocity.x*dt, player.velocity.y*dt};
+    RayVsRectBatch(inCenter, rayDir, player.size, 1.0f, candidateRects, candidateHits);
+
+    for(int k = 0; k < int(candidates.size()); k++)
+    {
+        if(!candidateHits.hit[k]) continue;
+
+        float t = candidateHits.tHitNear[k];
+        ray RectRay = {1, Vector2 {std::round(inCenter.x + t*rayDir.x), std::round(inCenter.y + t*rayDir.y)},
+                       Vector2 {candidateHits.normalX[k], candidateHits.normalY[k]}, t, statics.type[candidates[k]]};
+        z.push_back({candidates[k], RectRay.rayCheck, RectRay.type, RectRay});
+    }
+}
+}
+
+
+PROFILE_SCOPE("resolve");
+
+//This should theoretically sort the collisions by shortest to longest, then resolve the shortest collision. If i screwed up then please tell me!
+std::sort(z.begin(), z.end(), [](const collision& a, const collision& b)
+{
+    return a.second < b.second;
+});
+
+//the rays cached in z stay valid until a resolution (or a death) moves the player's sweep.
+//after that, a contact is only cast again if the new sweep can still reach it.
+Vector2 castPosition = player.position;
+Vector2 castVelocity = player.velocity;
+//the first contact the sweep actually stopped at, where the slide along it starts
+ray firstHit = zeroRay;
+
+for (const auto& j : z)
+{
+    ray RectRay = j.hit;
+    bool sweepChanged = player.position.x != castPosition.x || player.position.y != castPosition.y ||
+                        player.velocity.x != castVelocity.x || player.velocity.y != castVelocity.y;
+    if(sweepChanged){
+        Rectangle target = staticBounds(world, j.first);
+        if(rectsOverlap(sweptBounds(player, dt), target)){
+            RectRay = DynamicRectVSRect(player, Vector2 {target.x, target.y}, Vector2 {target.width, target.height}, statics.type[j.first], dt);
+        }
+        else{
+            RectRay = zeroRay;
+        }
+    }
+    if(!RectRay.collided) continue;
+    if(!firstHit.collided) firstHit = RectRay;
+
+    //the ground and wall flags are worked out from every surface touched once the loop is done
+    if(RectRay.rayCheck <= 1){
+        ContactsTouch(world.contacts, world.playerBody, j.first, staticBounds(world, j.first), RectRay.contact_normal);
+    }
+
+    //The collision is resolved by truncating the velocity to the point where the moving rectangle can never intersect with the static rectangle
+    //I also added a one-pixel buffer around the moving rectangle, as there were some issues with the origin of the raycast being from inside the static rectangle when the pixel buffer was removed.
+
+//only solids get this far, spikes are checked below
+ClipVelocity(player, RectRay);
+
+}
+
+//the clips above can turn the sweep into a slide that reaches something the first one didn't, see SimWorld::toiPasses
+if(firstHit.collided && firstHit.rayCheck <= 1){
+    PROFILE_SCOPE("slide");
+    int budget = world.toiBudget - world.toi.sweeps;
+    SlideAlong(player, castVelocity, firstHit, candidateRects, candidateHits, dt, world.toiPasses, budget, world.toi, [&](int k, const ray& hit){
+        ContactsTouch(world.contacts, world.playerBody, candidates[k], staticBounds(world, candidates[k]), hit.contact_normal);
+    });
+}
+
+//hazards are never swept against. once the solids have clipped the velocity, the hazards near the box covering the rest
+//of this step's path are overlap tested against the player moving along it, which is all a spike needs to know.
+//the box itself would be too much: moving diagonally it covers corners the player never goes through.
+{
+PROFILE_SCOPE("hazards");
+Vector2 move = {player.velocity.x*dt, player.velocity.y*dt};
+Rectangle path = {std::min(player.position.x, player.position.x + move.x),
+                  std::min(player.position.y, player.position.y + move.y),
+                  player.size.x + fabsf(move.x), player.size.y + fabsf(move.y)};
+candidates.clear();
+QueryStatics(world, path, candidates, world.playerKilledBy);
+for(int i : candidates){
+    if(sweptIntersects(rectBounds(player), move, staticBounds(world, i))){
+        playerDeath(world);
+        break;
+    }
+}
+}
+
+ContactsEndStep(world.contacts, world.playerBody);
+world.grounded = ContactsTouching(world.contacts, world.playerBody, Vector2 {0, -1});
+world.wallslidingRight = ContactsTouching(world.contacts, world.playerBody, Vector2 {-1, 0});
+world.wallslidingLeft = ContactsTouching(world.contacts, world.playerBody, Vector2 {1, 0});
+
+if(world.jumping && world.sliding){
+    world.brakingConstant = 0;
+}
+else {
+    world.brakingConstant = 30;
+}
+
+if(world.grounded){
+world.groundedCoyoteTimer = world.time + world.groundedCoyoteWindow;
+}
+
+if(world.wallslidingLeft){
+world.wallslideLeftCoyoteTimer = world.time + world.wallslideCoyoteWindow;
+}
+
+if(world.wallslidingRight){
+world.wallslideRightCoyoteTimer = world.time + world.wallslideCoyoteWindow;
+}
+//caps the player's downwards vertical speed when wallsliding
+if((world.wallslidingLeft || world.wallslidingRight) && player.velocity.y > 100){
+    player.velocity.y = 100;
+}
+
+//if the player's velocity is too slow, they won't be counted as sliding anymore
+if(std::abs(player.velocity.x) < 200 && world.sliding){
+    world.sliding = 0;
+}
+
+if((std::abs(player.velocity.x) < 1)){
+    player.velocity.x = 0;
+}
+//change the moving rectangle's position by its velocity modulated by deltaTime
+
+player.position.x += player.velocity.x * dt;
+player.position.y += player.velocity.y * dt;
+}
+
+void SimStep(SimWorld& world, const SimInput& input, float dt){
+    if(world.playerBody < 0 || world.playerBody >= int(world.bodies.size())) return;
+
+    PROFILE_SCOPE("SimStep");
+    world.time += dt;
+    world.toi = TOIStats {};
+    ApplyInput(world, input);
+    StepPhysics(world, dt);
+    StepBodies(world, dt);
+}
+
+int SimAdvance(SimWorld& world, SimClock& clock, const SimInput& input, float frameTime){
+    //held keys are whatever they are right now, presses pile up until a step uses them
+    SimInput& pending = clock.pending;
+    pending.left = input.left;
+    pending.right = input.right;
+    pending.crouch = input.crouch;
+    pending.jumpHeld = input.jumpHeld;
+    pending.leftPressed = pending.leftPressed || input.leftPressed;
+    pending.rightPressed = pending.rightPressed || input.rightPressed;
+    pending.crouchPressed = pending.crouchPressed || input.crouchPressed;
+    pending.jumpPressed = pending.jumpPressed || input.jumpPressed;
+    pending.respawn = pending.respawn || input.respawn;
+
+    clock.accumulator += frameTime;
+
+    int steps = 0;
+    while(clock.accumulator >= clock.stepDt){
+        if(steps == clock.maxSteps){
+            clock.accumulator = 0;
+            break;
+        }
+
+        clock.previousPositions.resize(world.bodies.size());
+        for(size_t i = 0; i < world.bodies.size(); i++) clock.previousPositions[i] = world.bodies[i].position;
+
+        SimStep(world, pending, clock.stepDt);
+        pending.leftPressed = pending.rightPressed = pending.crouchPressed = pending.jumpPressed = pending.respawn = false;
+
+        clock.accumulator -= clock.stepDt;
+        steps++;
+    }
+
+    clock.alpha = float(clock.accumulator / clock.stepDt);
+    clock.stepsLastFrame = steps;
+    return steps;
+}
+
+Vector2 InterpolatedPosition(const SimWorld& world, const SimClock& clock, int body){
+    Vector2 current = world.bodies[body].position;
+    //bodies that appeared since the last step have nothing to blend from
+    if(body >= int(clock.previousPositions.size())) return current;
+
+    return Vector2Lerp(clock.previousPositions[body], current, clock.alpha);
+}
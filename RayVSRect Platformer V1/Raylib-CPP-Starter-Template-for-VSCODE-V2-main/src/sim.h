@@ -0,0 +1,275 @@
+#ifndef SIM_H_
+#define SIM_H_
+
+//the simulation core: collision, movement and the level's rectangles, with no window, drawing or input polling.
+//raylib.h is only included for Vector2/Rectangle, nothing in here calls into raylib, so it links without it.
+#include "raylib.h"
+#include "broadphase.h"
+#include "aabbtree.h"
+#include "raybatch.h"
+#include "tilemap.h"
+#include "dynamics.h"
+#include "contacts.h"
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+struct JobSystem;
+
+// a raycasting function returns a ray. a ray's attributes are:
+//if it has intersected with a rectangle or not, (collided)
+//the coordinates where it intersects the rectangle, the direction of the x and y normals from the collision, (contact_point, contact_normal)
+//and the ratio of the shortest ray it would take to collide with the rectangle given its current direction to the ray's actual length. (rayCheck)
+//if rayCheck is below 1 AND collided is true, a collision has occured.
+
+struct ray {
+    bool collided;
+    Vector2 contact_point, contact_normal;
+    float rayCheck;
+    int type = 1;
+};
+
+//first is the index of the static rectangle, second is its rayCheck and third is its type.
+//hit keeps the whole ray from the detection pass so the resolution pass doesn't have to cast it again.
+struct collision {
+    int first;
+    float second;
+    int third;
+    ray hit;
+};
+//a collision function should return zeroRay when it knows a collision will not take place given the input parameters
+extern const ray zeroRay;
+
+struct movingRect{
+    Vector2 position;
+    Vector2 size;
+    int type = 1;
+    float mass = 1;
+    Vector2 velocity;
+    Vector2 acc;
+    Vector2 force;
+
+};
+
+//the state of the controls for one step. the game fills this in from the keyboard,
+//the headless runner fills it in from a script. "Pressed" means it went down since the last step.
+struct SimInput {
+    bool left, right;
+    bool leftPressed, rightPressed;
+    bool crouch, crouchPressed;
+    bool jumpPressed, jumpHeld;
+    bool respawn;
+};
+
+//the area a run of revisions touched, see SimWorld::levelChanges
+struct LevelChange {
+    unsigned int firstRevision, lastRevision;
+    Rectangle area;
+};
+#define LEVEL_CHANGE_HISTORY 256
+
+//everything the simulation needs to step. time is the simulated clock, it replaces GetTime() for all the timers.
+struct SimWorld {
+    //the level's static rectangles only need a position, a size and a type, so they're kept as a structure of arrays.
+    //that's 17 bytes a rectangle instead of a whole movingRect, and the batched ray kernel can read it directly.
+    RectSoA statics;
+
+    //the layer each static type is on (a CollisionLayer bit), types past the end are triggers.
+    //solids go in levelGrid/levelTree and everything else in triggerGrid/triggerTree, so the player's sweep never sees a spike.
+    //change it before loading a level, or call rebuildLevelGrid after.
+    std::vector<unsigned int> typeLayer = {LAYER_TRIGGER, LAYER_SOLID, LAYER_HAZARD};
+
+    //which tile chunk made each static rectangle, or -1 if it was drawn/loaded as a plain rectangle.
+    //statics streamed in by a LevelStream have STREAM_OWNER(chunk) here instead (see stream.h).
+    std::vector<int> staticOwner;
+    TileLayer tiles;
+
+    //the rectangles that actually move. the player is bodies[playerBody].
+    std::vector<movingRect> bodies;
+    int playerBody = 0;
+    //the working state for the other bodies, see dynamics.h
+    BodyDynamics dynamics;
+    //if this is set the bodies are stepped on its threads. the results are the same with or without it.
+    JobSystem* jobs = NULL;
+    //the surfaces the player was stopped by on the last steps, see contacts.h
+    ContactCache contacts;
+    //scratch space for the player's step. it's kept in the world rather than in statics inside StepPhysics,
+    //so two worlds can be stepped on different threads at once.
+    std::vector<int> stepResting, stepCandidates;
+    RectSoA stepCandidateRects;
+    RayBatchResult stepCandidateHits;
+
+    //every static rectangle is registered under its index in statics, either in the grid or, if it's bigger than treeMinSize
+    //either way, in the tree (a big block would fill hundreds of grid cells). staticProxy is its leaf in the tree, or -1.
+    //solid statics are in levelGrid and levelTree, the rest in triggerGrid and triggerTree.
+    //these have to be kept up to date whenever statics changes, so use addStatic/removeStatic instead of touching the arrays,
+    //and QueryStatics to look things up.
+    float tileSize = 16.0f;
+    SpatialGrid levelGrid;
+    AABBTree levelTree;
+    SpatialGrid triggerGrid;
+    AABBTree triggerTree;
+    std::vector<int> staticProxy;
+    float treeMinSize = 64.0f;
+
+    //goes up every time the static geometry changes, so anything cached from it (like the renderer's tiles) knows to rebuild
+    unsigned int levelRevision = 0;
+    //a ring of the areas recent revisions changed. lets a cache that only covers part of the level skip rebuilding
+    //when an edit happened somewhere else. changes inside the area of the newest entry just extend it,
+    //so re-merging a tile chunk is one entry however many colliders it goes through.
+    std::vector<LevelChange> levelChanges;
+    int newestChange = 0;
+
+    double time = 0;
+
+    //the layers the player is stopped by, and the ones that kill it when its path this step overlaps them
+    unsigned int playerCollidesWith = LAYER_SOLID;
+    unsigned int playerKilledBy = LAYER_HAZARD;
+
+    //continuous collision. the first sweep only finds the first time of impact: after clipping against it the mover slides,
+    //and the slide can run into something the original path missed (a fast fall onto the floor that slides into a peg).
+    //so a mover that was clipped is swept again from that contact along the rest of its slide, and again from the next
+    //contact, up to toiPasses sweeps in all. one still running into something after that is stopped at the contact.
+    //toiBudget is how many of those extra sweeps a whole step gets, the player goes first and the bodies split the rest.
+    //a mover that gets none keeps the result of its first sweep, which is what everything did before.
+    int toiPasses = 4;
+    int toiBudget = 4096;
+    TOIStats toi;
+
+    //game variables
+    Vector2 playerSpawn = Vector2 {100, 100};
+    float gravity = 1500;
+    float gravityModifier = 1;
+    float playerHeight = 31;
+    float crouchHeight = 23;
+    float playerSpeed = 300;
+    float slideSpeed = 750;
+    float accConstant = 30;
+    float brakingConstant = 30;
+    float groundedCoyoteTimer = 0;
+    float wallslideLeftCoyoteTimer = 0, wallslideRightCoyoteTimer = 0;
+    float groundedCoyoteWindow = 0.1;
+    float wallslideCoyoteWindow = 0.2;
+    bool crouching = 0;
+    bool sliding = 0;
+    float bufferJumpTimer = 0, noControlTimer = 0;
+    float bufferWindow = 0.1;
+    float noControlWindow = 0.20;
+    bool controlsEnabled = 1;
+    bool grounded = 0, jumping = 0, wallslidingRight = 0, wallslidingLeft = 0;
+    float jumpVel = 600;
+    float wallJumpVel = 420;
+    float pushoffVel = 400;
+};
+
+float sign(float in);
+
+//returns a ray struct after being given an origin, direction, and a rectangle (position, size and type) to collide with.
+ray RayVsRect(const Vector2& ray_origin, const Vector2& ray_dir, const Vector2& r_position, const Vector2& r_size, int r_type);
+ray RayVsRect(const Vector2& ray_origin, const Vector2& ray_dir, const movingRect& r);
+
+//returns a ray struct when given two rectangles, the "in" rectangle should be considered the moving one, and the "target" rectangle should be static (not moving).
+//The DynamicRectVSRect function calls the rayVsRect function. The ray's origin is the 'in' rectangle's center coordinates, and the ray direction is the 'in' rectangle's velocity modulated by deltaTime.
+//The single rectangle input for RayVsRect should be the 'target' rectangle expanded by half the width and height of the 'in' rectangle.
+//dt is the step time, it's passed in so a whole pass of checks only has to ask for it once.
+ray DynamicRectVSRect(const movingRect& in, const Vector2& target_position, const Vector2& target_size, int target_type, float dt);
+ray DynamicRectVSRect(const movingRect& in, const movingRect& target, float dt);
+
+//takes away the part of the velocity that would carry the rectangle past a hit (plus a pixel per second so it ends up just short of it)
+void ClipVelocity(movingRect& r, const ray& hit);
+
+//the sweeps after the first one, for a mover the first one clipped. castVelocity is what it was cast with and firstHit
+//the first contact that clipped it. rects is what the first sweep was tested against (the slide stays inside the
+//area that was queried for), hits is scratch space. every sweep follows the slide from the last contact and stops at the
+//nearest rectangle it runs into, ties going to the lowest index, calling touched with its index in rects.
+//it stops once the path is clear, or when the passes or the budget run out. the velocity is changed to cover the path
+//the slide ends up taking. returns how many sweeps it did and counts them in stats.
+int SlideAlong(movingRect& r, Vector2 castVelocity, const ray& firstHit, const RectSoA& rects, RayBatchResult& hits, float dt,
+               int passes, int& budget, TOIStats& stats, const std::function<void(int k, const ray& hit)>& touched);
+
+Rectangle rectBounds(const movingRect& r);
+
+//the area a rectangle sweeps through over dt, padded by a pixel so touching rectangles still count
+Rectangle sweptBounds(const movingRect& r, float dt);
+
+bool rectsOverlap(Rectangle a, Rectangle b);
+
+inline movingRect& SimPlayer(SimWorld& world){ return world.bodies[world.playerBody]; }
+inline const movingRect& SimPlayer(const SimWorld& world){ return world.bodies[world.playerBody]; }
+
+inline unsigned int StaticLayer(const SimWorld& world, int type){
+    return type >= 0 && type < int(world.typeLayer.size()) ? world.typeLayer[type] : (unsigned int)LAYER_TRIGGER;
+}
+
+inline Rectangle staticBounds(const SimWorld& world, int i){
+    return Rectangle {world.statics.x[i], world.statics.y[i], world.statics.w[i], world.statics.h[i]};
+}
+
+void addStatic(SimWorld& world, float x, float y, float w, float h, int type);
+
+//removes statics[i] by moving the last rectangle into its slot, so only one grid entry has to be renumbered
+void removeStatic(SimWorld& world, int i);
+
+//empties the level but keeps the tuning values
+void clearLevel(SimWorld& world);
+
+void rebuildLevelGrid(SimWorld& world);
+
+//trades the level (statics, tiles, the grid and tree over them, and the bodies) with other's, for putting in a level
+//that was loaded into a separate world on another thread. the tuning values, timers and job system stay where they are,
+//and the level counts as changed everywhere.
+void swapLevel(SimWorld& world, SimWorld& other);
+
+//appends the index of every static on one of the layers that might overlap the area, each one once, from both the grid and the tree
+void QueryStatics(SimWorld& world, Rectangle area, std::vector<int>& out, unsigned int layers);
+//the same, but it only reads the world so several threads can call it at once. it can return an index more than once.
+void QueryStaticsShared(const SimWorld& world, Rectangle area, std::vector<int>& out, unsigned int layers);
+
+//the same structures for a ray from origin to origin + dir, see GridRaycast
+void RaycastStatics(const SimWorld& world, Vector2 origin, Vector2 dir, std::vector<int>& out, unsigned int layers);
+
+//true if the rectangles overlap by more than just touching edges
+bool rectsIntersect(Rectangle a, Rectangle b);
+
+//true if r moving by move overlaps target by more than just touching edges at any point on the way
+bool sweptIntersects(Rectangle r, Vector2 move, Rectangle target);
+
+//bumps levelRevision and remembers which area changed. clearing or reloading the level counts as changing everything.
+void markLevelChanged(SimWorld& world, Rectangle area);
+
+//true if anything inside area might have changed after the given revision
+bool levelChangedSince(const SimWorld& world, unsigned int revision, Rectangle area);
+
+void applyForce(SimWorld& world, float fx, float fy);
+void playerDeath(SimWorld& world);
+void playerJump(SimWorld& world);
+
+//advances the world by exactly dt seconds using the given controls
+void SimStep(SimWorld& world, const SimInput& input, float dt);
+
+//runs the simulation at a fixed rate no matter how fast frames are drawn.
+//frame time goes into the accumulator and whole steps of stepDt come out of it, the leftover fraction is used to
+//draw the bodies part way between the last two steps so the movement stays smooth when the two rates don't line up.
+struct SimClock {
+    float stepDt = 1.0f / 120.0f;
+    //after this many steps in one frame the rest of the backlog is dropped, so a long hitch can't snowball into more and more steps
+    int maxSteps = 8;
+
+    double accumulator = 0;
+    float alpha = 0;
+    int stepsLastFrame = 0;
+
+    //presses that came in on frames where no step ran wait here until one does, so a quick tap is never lost
+    SimInput pending = {};
+
+    //where every body was before the newest step, for interpolation
+    std::vector<Vector2> previousPositions;
+};
+
+//feeds one frame's worth of time and controls into the clock, returns how many steps ran
+int SimAdvance(SimWorld& world, SimClock& clock, const SimInput& input, float frameTime);
+
+//a body's position blended between the last two steps by the clock's alpha
+Vector2 InterpolatedPosition(const SimWorld& world, const SimClock& clock, int body);
+
+#endif
@@ -0,0 +1,346 @@
+#include "stream.h"
+#include "sim.h"
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+static long long ChunkKey(int x, int y){
+    return (long long)(((unsigned long long)(unsigned int)x << 32) | (unsigned int)y);
+}
+
+static int ChunkCoord(float v, float size){
+    return int(floorf(v / size));
+}
+
+//how far outside the bounds the point is, along whichever axis is further
+static float DistanceTo(Rectangle bounds, Vector2 p){
+    float dx = std::max(std::max(bounds.x - p.x, p.x - (bounds.x + bounds.width)), 0.0f);
+    float dy = std::max(std::max(bounds.y - p.y, p.y - (bounds.y + bounds.height)), 0.0f);
+    return std::max(dx, dy);
+}
+
+bool saveLevelStreamed(const SimWorld& world, const char* fileName, float chunkSize){
+    const RectSoA& statics = world.statics;
+    const movingRect& player = SimPlayer(world);
+
+    //statics sorted by the chunk their top left corner is in, so each chunk's rectangles are one run
+    std::vector<int> order(SoACount(statics));
+    std::vector<long long> keys(order.size());
+    for(int i = 0; i < int(order.size()); i++){
+        order[i] = i;
+        keys[i] = ChunkKey(ChunkCoord(statics.x[i], chunkSize), ChunkCoord(statics.y[i], chunkSize));
+    }
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b){ return keys[a] < keys[b]; });
+
+    std::vector<StreamChunkEntry> entries;
+    for(size_t k = 0; k < order.size();){
+        size_t end = k;
+        while(end < order.size() && keys[order[end]] == keys[order[k]]) end++;
+
+        int first = order[k];
+        StreamChunkEntry entry;
+        entry.cx = ChunkCoord(statics.x[first], chunkSize);
+        entry.cy = ChunkCoord(statics.y[first], chunkSize);
+        entry.offset = 0;
+        entry.count = unsigned(end - k);
+        float x0 = entry.cx * chunkSize, y0 = entry.cy * chunkSize, x1 = x0 + chunkSize, y1 = y0 + chunkSize;
+        for(size_t j = k; j < end; j++){
+            int i = order[j];
+            x0 = std::min(x0, statics.x[i]);
+            y0 = std::min(y0, statics.y[i]);
+            x1 = std::max(x1, statics.x[i] + statics.w[i]);
+            y1 = std::max(y1, statics.y[i] + statics.h[i]);
+        }
+        entry.bounds = Rectangle {x0, y0, x1 - x0, y1 - y0};
+        entries.push_back(entry);
+        k = end;
+    }
+
+    StreamFileHeader header;
+    memcpy(header.magic, STREAM_FILE_MAGIC, 4);
+    header.version = STREAM_FILE_VERSION;
+    header.chunkSize = chunkSize;
+    header.chunkCount = unsigned(entries.size());
+    header.playerType = player.type;
+    header.player[0] = player.position.x;
+    header.player[1] = player.position.y;
+    header.player[2] = player.size.x;
+    header.player[3] = player.size.y;
+
+    unsigned int offset = unsigned(sizeof(header) + entries.size()*sizeof(StreamChunkEntry));
+    for(StreamChunkEntry& entry : entries){
+        entry.offset = offset;
+        offset += entry.count*(4*sizeof(float) + 1);
+    }
+
+    FILE* file = fopen(fileName, "wb");
+    if(file == NULL) return false;
+
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    if(!entries.empty()) ok = ok && fwrite(entries.data(), sizeof(StreamChunkEntry), entries.size(), file) == entries.size();
+
+    //one chunk at a time, in the same layout a binary level uses for all of its statics
+    std::vector<float> floats;
+    std::vector<unsigned char> types;
+    size_t k = 0;
+    for(const StreamChunkEntry& entry : entries){
+        floats.resize(4*entry.count);
+        types.resize(entry.count);
+        for(unsigned int j = 0; j < entry.count; j++){
+            int i = order[k + j];
+            floats[j] = statics.x[i];
+            floats[entry.count + j] = statics.y[i];
+            floats[2*entry.count + j] = statics.w[i];
+            floats[3*entry.count + j] = statics.h[i];
+            types[j] = statics.type[i];
+        }
+        ok = ok && fwrite(floats.data(), sizeof(float), floats.size(), file) == floats.size();
+        ok = ok && fwrite(types.data(), 1, types.size(), file) == types.size();
+        k += entry.count;
+    }
+    return fclose(file) == 0 && ok;
+}
+
+//reads one chunk, this runs on the worker thread and only touches the file and the (unchanging) chunk table
+static bool ReadChunk(LevelStream& stream, int chunk, RectSoA& rects){
+    const StreamChunkEntry& entry = stream.chunks[chunk];
+    size_t count = entry.count;
+    rects.x.resize(count);
+    rects.y.resize(count);
+    rects.w.resize(count);
+    rects.h.resize(count);
+    rects.type.resize(count);
+    if(count == 0) return true;
+
+    if(fseek(stream.file, long(entry.offset), SEEK_SET) != 0) return false;
+    return fread(rects.x.data(), sizeof(float), count, stream.file) == count &&
+           fread(rects.y.data(), sizeof(float), count, stream.file) == count &&
+           fread(rects.w.data(), sizeof(float), count, stream.file) == count &&
+           fread(rects.h.data(), sizeof(float), count, stream.file) == count &&
+           fread(rects.type.data(), 1, count, stream.file) == count;
+}
+
+static void StreamWorker(LevelStream* stream){
+    for(;;){
+        int chunk;
+        {
+            std::unique_lock<std::mutex> guard(stream->lock);
+            stream->wake.wait(guard, [&]{
+                return stream->quit || (!stream->requests.empty() && int(stream->ready.size()) < stream->maxReady);
+            });
+            if(stream->quit) return;
+            chunk = stream->requests.front();
+            stream->requests.pop_front();
+        }
+
+        StreamReady item;
+        item.chunk = chunk;
+        item.added = 0;
+        //a chunk that can't be read comes back empty, so the main thread doesn't wait for it forever
+        if(!ReadChunk(*stream, chunk, item.rects)){
+            fprintf(stderr, "couldn't read level chunk %d\n", chunk);
+            SoAClear(item.rects);
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(stream->lock);
+            stream->ready.push_back(std::move(item));
+        }
+        stream->wake.notify_all();
+    }
+}
+
+void StreamClose(LevelStream& stream){
+    if(stream.worker.joinable()){
+        {
+            std::lock_guard<std::mutex> guard(stream.lock);
+            stream.quit = true;
+        }
+        stream.wake.notify_all();
+        stream.worker.join();
+    }
+    if(stream.file != NULL) fclose(stream.file);
+    stream.file = NULL;
+    stream.quit = false;
+    stream.requests.clear();
+    stream.ready.clear();
+    stream.chunks.clear();
+    stream.state.clear();
+    stream.chunkIndex.clear();
+    stream.loaded.clear();
+}
+
+LevelStream::~LevelStream(){
+    StreamClose(*this);
+}
+
+bool StreamOpen(LevelStream& stream, SimWorld& world, const char* fileName){
+    StreamClose(stream);
+
+    FILE* file = fopen(fileName, "rb");
+    if(file == NULL){
+        fprintf(stderr, "could not open level %s\n", fileName);
+        return false;
+    }
+
+    StreamFileHeader header;
+    if(fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, STREAM_FILE_MAGIC, 4) != 0 ||
+       header.version != STREAM_FILE_VERSION){
+        fprintf(stderr, "%s is not a streamed level this version can read\n", fileName);
+        fclose(file);
+        return false;
+    }
+
+    stream.chunks.resize(header.chunkCount);
+    if(header.chunkCount > 0 && fread(stream.chunks.data(), sizeof(StreamChunkEntry), header.chunkCount, file) != header.chunkCount){
+        fprintf(stderr, "%s is truncated\n", fileName);
+        stream.chunks.clear();
+        fclose(file);
+        return false;
+    }
+
+    stream.file = file;
+    stream.chunkSize = header.chunkSize;
+    stream.state.assign(stream.chunks.size(), CHUNK_UNLOADED);
+    stream.overhang = 0;
+    for(int i = 0; i < int(stream.chunks.size()); i++){
+        const StreamChunkEntry& entry = stream.chunks[i];
+        stream.chunkIndex[ChunkKey(entry.cx, entry.cy)] = i;
+        float x0 = entry.cx * stream.chunkSize, y0 = entry.cy * stream.chunkSize;
+        stream.overhang = std::max(stream.overhang, entry.bounds.x + entry.bounds.width - (x0 + stream.chunkSize));
+        stream.overhang = std::max(stream.overhang, entry.bounds.y + entry.bounds.height - (y0 + stream.chunkSize));
+    }
+
+    clearLevel(world);
+    movingRect player {};
+    player.position = Vector2 {header.player[0], header.player[1]};
+    player.size = Vector2 {header.player[2], header.player[3]};
+    player.type = header.playerType;
+    world.bodies.push_back(player);
+    world.playerBody = 0;
+
+    stream.worker = std::thread(StreamWorker, &stream);
+    StreamUpdate(stream, world, Vector2 {player.position.x + player.size.x/2, player.position.y + player.size.y/2}, true);
+    return true;
+}
+
+//asks the worker for every chunk near focus that isn't loaded yet, nearest first. returns how many are still on their way.
+static int RequestChunks(LevelStream& stream, Vector2 focus){
+    float size = stream.chunkSize;
+    float reach = stream.loadDistance;
+    int x0 = ChunkCoord(focus.x - reach - stream.overhang, size), x1 = ChunkCoord(focus.x + reach, size);
+    int y0 = ChunkCoord(focus.y - reach - stream.overhang, size), y1 = ChunkCoord(focus.y + reach, size);
+
+    std::vector<std::pair<float, int>>& wanted = stream.wanted;
+    wanted.clear();
+    int pending = 0;
+    for(int cy = y0; cy <= y1; cy++){
+        for(int cx = x0; cx <= x1; cx++){
+            auto it = stream.chunkIndex.find(ChunkKey(cx, cy));
+            if(it == stream.chunkIndex.end()) continue;
+            int chunk = it->second;
+            float distance = DistanceTo(stream.chunks[chunk].bounds, focus);
+            if(distance > reach) continue;
+            if(stream.state[chunk] == CHUNK_QUEUED) pending++;
+            if(stream.state[chunk] != CHUNK_UNLOADED) continue;
+            wanted.push_back(std::make_pair(distance, chunk));
+        }
+    }
+    if(wanted.empty()) return pending;
+
+    std::sort(wanted.begin(), wanted.end());
+    {
+        std::lock_guard<std::mutex> guard(stream.lock);
+        for(const auto& w : wanted){
+            stream.state[w.second] = CHUNK_QUEUED;
+            stream.requests.push_back(w.second);
+        }
+    }
+    stream.wake.notify_all();
+    return pending + int(wanted.size());
+}
+
+//moves finished chunks into the world until budget rectangles have been added
+static void AddReadyChunks(LevelStream& stream, SimWorld& world, Vector2 focus, int budget){
+    stream.addedLastUpdate = 0;
+    for(;;){
+        StreamReady* item;
+        {
+            std::lock_guard<std::mutex> guard(stream.lock);
+            if(stream.ready.empty()) return;
+            item = &stream.ready.front();
+        }
+
+        int chunk = item->chunk;
+        const StreamChunkEntry& entry = stream.chunks[chunk];
+        //the camera moved on while it was being read
+        bool stale = item->added == 0 && DistanceTo(entry.bounds, focus) > stream.unloadDistance;
+
+        if(!stale){
+            //marking the whole chunk first means every addStatic below just extends this one change
+            markLevelChanged(world, entry.bounds);
+            const RectSoA& rects = item->rects;
+            int count = SoACount(rects);
+            while(item->added < count && budget > 0){
+                int i = item->added++;
+                addStatic(world, rects.x[i], rects.y[i], rects.w[i], rects.h[i], rects.type[i]);
+                world.staticOwner.back() = STREAM_OWNER(chunk);
+                budget--;
+                stream.addedLastUpdate++;
+            }
+            if(item->added < count) return;
+
+            stream.state[chunk] = CHUNK_LOADED;
+            stream.loaded.push_back(chunk);
+            stream.chunksLoaded++;
+        }
+        else stream.state[chunk] = CHUNK_UNLOADED;
+
+        {
+            std::lock_guard<std::mutex> guard(stream.lock);
+            stream.ready.pop_front();
+        }
+        //there's room in the ready queue again
+        stream.wake.notify_all();
+    }
+}
+
+static void UnloadChunk(LevelStream& stream, SimWorld& world, int chunk){
+    markLevelChanged(world, stream.chunks[chunk].bounds);
+
+    //walking backwards, the rectangle removeStatic moves into slot i has already been looked at
+    int owner = STREAM_OWNER(chunk);
+    for(int i = SoACount(world.statics) - 1; i >= 0; i--){
+        if(world.staticOwner[i] == owner) removeStatic(world, i);
+    }
+    stream.state[chunk] = CHUNK_UNLOADED;
+    stream.chunksUnloaded++;
+}
+
+void StreamUpdate(LevelStream& stream, SimWorld& world, Vector2 focus, bool wait){
+    if(!StreamActive(stream)) return;
+
+    RequestChunks(stream, focus);
+    AddReadyChunks(stream, world, focus, wait ? 0x7fffffff : stream.addBudget);
+
+    //counting what's still queued after adding, the worker may already have finished everything that was asked for
+    while(wait && RequestChunks(stream, focus) > 0){
+        {
+            std::unique_lock<std::mutex> guard(stream.lock);
+            stream.wake.wait(guard, [&]{ return !stream.ready.empty(); });
+        }
+        AddReadyChunks(stream, world, focus, 0x7fffffff);
+    }
+
+    //one far away chunk a frame is plenty, the camera can't outrun that
+    for(int k = 0; k < int(stream.loaded.size()); k++){
+        int chunk = stream.loaded[k];
+        if(DistanceTo(stream.chunks[chunk].bounds, focus) <= stream.unloadDistance) continue;
+        UnloadChunk(stream, world, chunk);
+        stream.loaded[k] = stream.loaded.back();
+        stream.loaded.pop_back();
+        if(!wait) break;
+        k--;
+    }
+}
@@ -0,0 +1,105 @@
+#ifndef STREAM_H_
+#define STREAM_H_
+
+//streaming a level that's too big to keep loaded all at once. the level is cut into square chunks (a .rvs file,
+//see levelconv) and only the chunks near a focus point (the camera) are in the world. a background thread reads
+//and decodes chunks, the main thread adds them to the world a limited number of rectangles per frame and drops
+//chunks that have fallen far enough behind, so crossing chunk edges never costs a whole chunk's work in one frame.
+
+#include "raylib.h"
+#include "raybatch.h"
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+struct SimWorld;
+
+//a .rvs file: a StreamFileHeader, chunkCount StreamChunkEntrys, then each chunk's rectangles laid out like a
+//binary level (every x, then every y, w and h as floats, then every type as one byte) at the entry's offset.
+//a rectangle belongs to the chunk its top left corner is in, bounds covers everything it owns.
+#define STREAM_FILE_MAGIC "RVST"
+#define STREAM_FILE_VERSION 1u
+
+struct StreamFileHeader {
+    char magic[4];
+    unsigned int version;
+    float chunkSize;
+    unsigned int chunkCount;
+    int playerType;
+    float player[4];
+};
+
+struct StreamChunkEntry {
+    int cx, cy;
+    unsigned int offset, count;
+    Rectangle bounds;
+};
+
+//statics streamed in from chunk n have SimWorld::staticOwner set to this
+#define STREAM_OWNER(n) (-2 - (n))
+
+enum StreamChunkState { CHUNK_UNLOADED, CHUNK_QUEUED, CHUNK_LOADED };
+
+struct StreamReady {
+    int chunk;
+    RectSoA rects;
+    int added;      //how many of rects are in the world so far
+};
+
+struct LevelStream {
+    std::vector<StreamChunkEntry> chunks;
+    std::vector<unsigned char> state;
+    std::unordered_map<long long, int> chunkIndex;
+    std::vector<int> loaded;
+    //scratch for RequestChunks: the unloaded chunks near the focus and how far away they are
+    std::vector<std::pair<float, int>> wanted;
+    float chunkSize = 1024.0f;
+    //how far a chunk's rectangles can reach outside the chunk, so the search around the focus looks far enough
+    float overhang = 0;
+
+    //chunks whose bounds come within loadDistance of the focus are loaded, ones further than unloadDistance are dropped.
+    //the gap between the two stops a chunk from loading and unloading over and over at the edge.
+    float loadDistance = 1500.0f;
+    float unloadDistance = 2500.0f;
+    //the most rectangles added to the world in one StreamUpdate, the rest wait for the next frame
+    int addBudget = 2000;
+    //the worker stops reading ahead when this many decoded chunks are waiting, so memory stays bounded
+    int maxReady = 16;
+
+    //shared with the worker
+    std::thread worker;
+    std::mutex lock;
+    std::condition_variable wake;
+    std::deque<int> requests;
+    std::deque<StreamReady> ready;
+    bool quit = false;
+    FILE* file = NULL;
+
+    //counters for the debug text
+    int chunksLoaded = 0, chunksUnloaded = 0;
+    int addedLastUpdate = 0;
+
+    ~LevelStream();
+};
+
+//writes the world's statics and player out as a streamed level
+bool saveLevelStreamed(const SimWorld& world, const char* fileName, float chunkSize);
+
+//empties the world, puts the player in and starts streaming around it. the chunks it starts in are loaded before this returns.
+bool StreamOpen(LevelStream& stream, SimWorld& world, const char* fileName);
+
+//call once a frame, between simulation steps. asks for chunks near focus, adds what the worker has finished
+//(up to addBudget rectangles) and unloads one far away chunk. with wait set it blocks until everything near focus is in.
+void StreamUpdate(LevelStream& stream, SimWorld& world, Vector2 focus, bool wait = false);
+
+//stops the worker and forgets the file, the world keeps whatever was loaded
+void StreamClose(LevelStream& stream);
+
+inline bool StreamActive(const LevelStream& stream){ return stream.file != NULL; }
+
+#endif
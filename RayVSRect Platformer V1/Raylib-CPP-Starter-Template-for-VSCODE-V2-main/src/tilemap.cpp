@@ -0,0 +1,197 @@
+#include "tilemap.h"
+#include "sim.h"
+
+#include <math.h>
+#include <string.h>
+
+static long long ChunkKey(int x, int y){
+    return (long long)(((unsigned long long)(unsigned int)x << 32) | (unsigned int)y);
+}
+
+static int FloorDiv(int a, int b){
+    return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+int TileCell(const SimWorld& world, float worldPos){
+    return int(floorf(worldPos / world.tileSize));
+}
+
+//the chunk holding a cell and the cell's index inside it, or -1 if nothing has been painted in that chunk
+static int FindChunk(const SimWorld& world, int cellX, int cellY, int& local){
+    const int N = TILE_CHUNK_SIZE;
+    int cx = FloorDiv(cellX, N), cy = FloorDiv(cellY, N);
+    local = (cellY - cy*N)*N + (cellX - cx*N);
+
+    auto it = world.tiles.chunkIndex.find(ChunkKey(cx, cy));
+    return it == world.tiles.chunkIndex.end() ? -1 : it->second;
+}
+
+static int ChunkFor(SimWorld& world, int cellX, int cellY, int& local){
+    int chunk = FindChunk(world, cellX, cellY, local);
+    if(chunk >= 0) return chunk;
+
+    TileChunk newChunk;
+    newChunk.cx = FloorDiv(cellX, TILE_CHUNK_SIZE);
+    newChunk.cy = FloorDiv(cellY, TILE_CHUNK_SIZE);
+    memset(newChunk.cells, 0, sizeof(newChunk.cells));
+    memset(newChunk.cellCollider, 0xff, sizeof(newChunk.cellCollider));
+
+    chunk = int(world.tiles.chunks.size());
+    world.tiles.chunks.push_back(newChunk);
+    world.tiles.chunkIndex[ChunkKey(newChunk.cx, newChunk.cy)] = chunk;
+    return chunk;
+}
+
+int GetTile(const SimWorld& world, int cellX, int cellY){
+    int local;
+    int chunk = FindChunk(world, cellX, cellY, local);
+    return chunk < 0 ? 0 : world.tiles.chunks[chunk].cells[local];
+}
+
+int TileCollider(const SimWorld& world, int cellX, int cellY){
+    int local;
+    int chunk = FindChunk(world, cellX, cellY, local);
+    if(chunk < 0) return -1;
+
+    const TileChunk& c = world.tiles.chunks[chunk];
+    int slot = c.cellCollider[local];
+    return slot < 0 ? -1 : c.colliders[slot];
+}
+
+//removes the chunk's old colliders and greedily merges its tiles into new ones:
+//take the first unused tile, grow it right as far as the same type goes, then grow that strip down while every row matches.
+static void MergeChunk(SimWorld& world, int chunk){
+    //marking the whole chunk first makes all the removes and adds below one change for the renderer
+    const int N = TILE_CHUNK_SIZE;
+    float size = world.tileSize;
+    TileChunk& c = world.tiles.chunks[chunk];
+    markLevelChanged(world, Rectangle {c.cx*N*size, c.cy*N*size, N*size, N*size});
+
+    //removeStatic sets each slot to -1 as it goes, and renumbers any slot whose collider gets moved.
+    //the cells are unhooked from their slots first, so removing the colliders doesn't clear the tiles they covered.
+    memset(c.cellCollider, 0xff, sizeof(c.cellCollider));
+    for(size_t k = 0; k < c.colliders.size(); k++){
+        while(c.colliders[k] >= 0) removeStatic(world, c.colliders[k]);
+    }
+
+    c.colliders.clear();
+
+    const unsigned char* types = c.cells;
+    int baseX = c.cx * N;
+    int baseY = c.cy * N;
+
+    for(int y = 0; y < N; y++){
+        for(int x = 0; x < N; x++){
+            unsigned char type = types[y*N + x];
+            if(type == 0 || c.cellCollider[y*N + x] >= 0) continue;
+
+            int w = 1;
+            while(x + w < N && types[y*N + x + w] == type && c.cellCollider[y*N + x + w] < 0) w++;
+
+            int h = 1;
+            while(y + h < N){
+                bool rowMatches = true;
+                for(int k = 0; k < w; k++){
+                    int i = (y + h)*N + x + k;
+                    if(types[i] != type || c.cellCollider[i] >= 0){
+                        rowMatches = false;
+                        break;
+                    }
+                }
+                if(!rowMatches) break;
+                h++;
+            }
+
+            short slot = short(c.colliders.size());
+            for(int dy = 0; dy < h; dy++){
+                for(int dx = 0; dx < w; dx++) c.cellCollider[(y + dy)*N + x + dx] = slot;
+            }
+
+            addStatic(world, (baseX + x)*size, (baseY + y)*size, w*size, h*size, type);
+            int index = SoACount(world.statics) - 1;
+            world.staticOwner[index] = chunk;
+            c.colliders.push_back(index);
+        }
+    }
+}
+
+void SetTile(SimWorld& world, int cellX, int cellY, int type){
+    int local;
+    int chunk = FindChunk(world, cellX, cellY, local);
+    int current = chunk < 0 ? 0 : world.tiles.chunks[chunk].cells[local];
+    if(current == type) return;
+
+    if(chunk < 0) chunk = ChunkFor(world, cellX, cellY, local);
+    world.tiles.chunks[chunk].cells[local] = (unsigned char)type;
+
+    MergeChunk(world, chunk);
+}
+
+void TilesAdoptStatics(SimWorld& world, const unsigned char* tiles){
+    const RectSoA& statics = world.statics;
+    float size = world.tileSize;
+    const int N = TILE_CHUNK_SIZE;
+
+    for(int i = 0; i < SoACount(statics); i++){
+        if(!tiles[i] || world.staticOwner[i] >= 0 || statics.type[i] == 0) continue;
+
+        //a flagged rectangle still has to be made of whole cells inside one chunk, a hand edited file might not be
+        float fx = statics.x[i] / size, fy = statics.y[i] / size;
+        float fw = statics.w[i] / size, fh = statics.h[i] / size;
+        if(fx != floorf(fx) || fy != floorf(fy) || fw != floorf(fw) || fh != floorf(fh) || fw < 1 || fh < 1) continue;
+
+        int x0 = int(fx), y0 = int(fy), w = int(fw), h = int(fh);
+        if(FloorDiv(x0, N) != FloorDiv(x0 + w - 1, N) || FloorDiv(y0, N) != FloorDiv(y0 + h - 1, N)) continue;
+
+        int local;
+        int chunk = ChunkFor(world, x0, y0, local);
+        TileChunk& c = world.tiles.chunks[chunk];
+
+        //or overlap a collider that was already adopted
+        bool free = true;
+        for(int y = 0; y < h && free; y++){
+            for(int x = 0; x < w; x++){
+                if(c.cells[local + y*N + x] != 0){
+                    free = false;
+                    break;
+                }
+            }
+        }
+        if(!free) continue;
+
+        short slot = short(c.colliders.size());
+        for(int y = 0; y < h; y++){
+            memset(c.cells + local + y*N, statics.type[i], w);
+            for(int x = 0; x < w; x++) c.cellCollider[local + y*N + x] = slot;
+        }
+        c.colliders.push_back(i);
+        world.staticOwner[i] = chunk;
+    }
+}
+
+void ClearTiles(SimWorld& world){
+    world.tiles.chunks.clear();
+    world.tiles.chunkIndex.clear();
+}
+
+void TilesStaticMoved(SimWorld& world, int from, int to){
+    int owner = world.staticOwner[from];
+    if(owner < 0) return;
+
+    TileChunk& c = world.tiles.chunks[owner];
+    for(int slot = 0; slot < int(c.colliders.size()); slot++){
+        if(c.colliders[slot] != from) continue;
+        c.colliders[slot] = to;
+
+        //a collider removed from outside the tile map (like undo) takes its tiles with it,
+        //otherwise they'd still be painted and come back the next time anything in the chunk is merged
+        if(to < 0){
+            for(int k = 0; k < TILE_CHUNK_SIZE*TILE_CHUNK_SIZE; k++){
+                if(c.cellCollider[k] != slot) continue;
+                c.cells[k] = 0;
+                c.cellCollider[k] = -1;
+            }
+        }
+        return;
+    }
+}
@@ -0,0 +1,55 @@
+#ifndef TILEMAP_H_
+#define TILEMAP_H_
+
+#include <unordered_map>
+#include <vector>
+
+struct SimWorld;
+
+//tiles are stored and merged in square chunks of this many cells, a merged collider never crosses a chunk edge.
+//that keeps the work for one painted tile down to re-merging its own chunk.
+#define TILE_CHUNK_SIZE 32
+
+//one chunk of the tile map. the cells are a plain array, so once the chunk is found a lookup is just an index.
+struct TileChunk {
+    int cx, cy;
+    unsigned char cells[TILE_CHUNK_SIZE*TILE_CHUNK_SIZE];
+
+    //the colliders this chunk's tiles were merged into, as indices into SimWorld::statics.
+    //a slot is -1 if its collider was removed from outside (like undo), which clears the cells it covered too.
+    //slots only get reused when the chunk is merged again.
+    std::vector<int> colliders;
+    //which slot of colliders covers each cell, or -1
+    short cellCollider[TILE_CHUNK_SIZE*TILE_CHUNK_SIZE];
+};
+
+//painted grid tiles. every cell keeps its own type so it can still be edited one tile at a time,
+//but collision (and drawing) only sees the bigger rectangles the tiles were greedily merged into.
+//only chunks that have been painted in exist, so the map can be as big as the world.
+struct TileLayer {
+    std::vector<TileChunk> chunks;
+    std::unordered_map<long long, int> chunkIndex;
+};
+
+//type 0 clears the cell. the tile's chunk is re-merged straight away, painting a cell with the type it already has does nothing.
+void SetTile(SimWorld& world, int cellX, int cellY, int type);
+int GetTile(const SimWorld& world, int cellX, int cellY);
+
+//the index in SimWorld::statics of the collider covering a cell, or -1
+int TileCollider(const SimWorld& world, int cellX, int cellY);
+
+//which cell a world position falls in
+int TileCell(const SimWorld& world, float worldPos);
+
+//hands the statics whose tiles[i] is set back to the tile map as the colliders of the cells they cover,
+//so a loaded level can be edited tile by tile again. they keep their index and aren't re-merged until their chunk is next painted.
+//anything that isn't whole cells inside one chunk stays a plain static.
+void TilesAdoptStatics(SimWorld& world, const unsigned char* tiles);
+
+void ClearTiles(SimWorld& world);
+
+//called by removeStatic when it moves a collider to a new index. a "to" of -1 means the collider is being removed,
+//and the tiles under it are cleared.
+void TilesStaticMoved(SimWorld& world, int from, int to);
+
+#endif
@@ -0,0 +1,163 @@
+//packs a set of images into as few atlas textures as it can, and writes a manifest of where each one ended up.
+//usage: atlaspack [--max size] [--padding pixels] <output> <image>...
+//writes <output>0.png, <output>1.png... and <output>.txt. "make atlas" runs it over textures/*.png.
+//
+//the manifest is one line per page then one per sprite:
+//  page,<png file name, next to the manifest>
+//  sprite,<name>,<page>,<x>,<y>,<width>,<height>
+//a sprite's name is its file name without the folder or extension. frames of an animation are numbered
+//(DogePlayer1.png, DogePlayer2.png...), see CreateAtlasAnimation in src/atlas.h.
+//
+//unlike the other tools this one links raylib, for loading and saving the pngs. it doesn't open a window.
+
+#include "raylib.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+struct PackImage {
+    std::string name;
+    Image image;
+    int page;
+    int x, y;
+};
+
+//shelf packing: images go left to right along a shelf as tall as the first (tallest) one on it, and a new shelf
+//starts under it when the row is full. with the images sorted tallest first that wastes very little for sprites.
+//places what it can of images (in order) on one size x size page and returns how many that was.
+static int PackPage(std::vector<PackImage*>& images, int size, int padding, bool place){
+    int shelfX = 0, shelfY = 0, shelfHeight = 0;
+    int placed = 0;
+    for(PackImage* p : images){
+        int w = p->image.width + padding, h = p->image.height + padding;
+        if(w > size || h > size) break;
+        if(shelfX + w > size){
+            shelfY += shelfHeight;
+            shelfX = 0;
+            shelfHeight = 0;
+        }
+        if(shelfY + h > size) break;
+
+        if(place){
+            p->x = shelfX;
+            p->y = shelfY;
+        }
+        shelfX += w;
+        shelfHeight = std::max(shelfHeight, h);
+        placed++;
+    }
+    return placed;
+}
+
+static std::string SpriteName(const char* path){
+    const char* name = path;
+    for(const char* c = path; *c != 0; c++){
+        if(*c == '/' || *c == '\\') name = c + 1;
+    }
+    std::string result = name;
+    size_t dot = result.rfind('.');
+    if(dot != std::string::npos) result.erase(dot);
+    return result;
+}
+
+int main(int argc, char** argv){
+    int maxSize = 2048;
+    int padding = 1;
+    int arg = 1;
+    while(arg < argc && strncmp(argv[arg], "--", 2) == 0){
+        if(strcmp(argv[arg], "--max") == 0 && arg + 1 < argc) maxSize = atoi(argv[++arg]);
+        else if(strcmp(argv[arg], "--padding") == 0 && arg + 1 < argc) padding = atoi(argv[++arg]);
+        else{
+            fprintf(stderr, "unknown option %s\n", argv[arg]);
+            return 1;
+        }
+        arg++;
+    }
+    if(argc - arg < 2){
+        fprintf(stderr, "usage: atlaspack [--max size] [--padding pixels] <output> <image>...\n");
+        return 1;
+    }
+    std::string output = argv[arg++];
+    std::string outputName = SpriteName(output.c_str());
+
+    SetTraceLogLevel(LOG_WARNING);
+
+    std::vector<PackImage> images;
+    for(; arg < argc; arg++){
+        std::string name = SpriteName(argv[arg]);
+        //the atlases from the last run are in the same folder, they don't go into themselves
+        if(name.compare(0, outputName.size(), outputName) == 0) continue;
+
+        Image image = LoadImage(argv[arg]);
+        if(image.data == NULL){
+            fprintf(stderr, "could not load %s\n", argv[arg]);
+            return 1;
+        }
+        if(image.width + padding > maxSize || image.height + padding > maxSize){
+            fprintf(stderr, "%s (%dx%d) doesn't fit in a %d pixel atlas\n", argv[arg], image.width, image.height, maxSize);
+            return 1;
+        }
+        ImageFormat(&image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+        images.push_back(PackImage {name, image, 0, 0, 0});
+    }
+
+    //tallest first, then widest, then by name so the same files always give the same atlas
+    std::vector<PackImage*> remaining;
+    for(PackImage& p : images) remaining.push_back(&p);
+    std::sort(remaining.begin(), remaining.end(), [](const PackImage* a, const PackImage* b){
+        if(a->image.height != b->image.height) return a->image.height > b->image.height;
+        if(a->image.width != b->image.width) return a->image.width > b->image.width;
+        return a->name < b->name;
+    });
+
+    std::vector<int> pageSizes;
+    while(!remaining.empty()){
+        //the smallest power of two page that holds everything left, or a full size page filled as far as it goes
+        int size = 64;
+        while(size < maxSize && PackPage(remaining, size, padding, false) < int(remaining.size())) size *= 2;
+        size = std::min(size, maxSize);
+
+        int placed = PackPage(remaining, size, padding, true);
+        for(int i = 0; i < placed; i++) remaining[i]->page = int(pageSizes.size());
+        remaining.erase(remaining.begin(), remaining.begin() + placed);
+        pageSizes.push_back(size);
+    }
+
+    std::string manifestName = output + ".txt";
+    FILE* manifest = fopen(manifestName.c_str(), "w");
+    if(manifest == NULL){
+        fprintf(stderr, "could not write %s\n", manifestName.c_str());
+        return 1;
+    }
+
+    for(int page = 0; page < int(pageSizes.size()); page++){
+        Image atlas = GenImageColor(pageSizes[page], pageSizes[page], BLANK);
+        for(const PackImage& p : images){
+            if(p.page != page) continue;
+            Rectangle source = {0, 0, float(p.image.width), float(p.image.height)};
+            ImageDraw(&atlas, p.image, source, Rectangle {float(p.x), float(p.y), source.width, source.height}, WHITE);
+        }
+
+        std::string pageFile = output + std::to_string(page) + ".png";
+        if(!ExportImage(atlas, pageFile.c_str())){
+            fprintf(stderr, "could not write %s\n", pageFile.c_str());
+            fclose(manifest);
+            return 1;
+        }
+        UnloadImage(atlas);
+        fprintf(manifest, "page,%s\n", SpriteName(pageFile.c_str()).append(".png").c_str());
+    }
+
+    for(const PackImage& p : images){
+        fprintf(manifest, "sprite,%s,%d,%d,%d,%d,%d\n", p.name.c_str(), p.page, p.x, p.y, p.image.width, p.image.height);
+    }
+    fclose(manifest);
+
+    for(PackImage& p : images) UnloadImage(p.image);
+    printf("packed %d images into %d page(s), manifest %s\n", int(images.size()), int(pageSizes.size()), manifestName.c_str());
+    return 0;
+}
@@ -0,0 +1,287 @@
+//microbenchmarks for the collision code: single rays, swept rectangles, the batched kernel, whole simulation steps
+//on procedurally generated levels of 10, 1k and 100k rectangles, bodies at rest, scene queries and level loading.
+//usage: bench [filter] [min seconds per benchmark]
+//only benchmarks whose name contains filter are run. the results go to stdout as json so they can be compared
+//across commits, progress goes to stderr.
+
+#include "../src/sim.h"
+#include "../src/level.h"
+#include "../src/query.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <math.h>
+#include <string>
+#include <vector>
+
+//everything a benchmark computes is folded into this, so the compiler can't throw the work away
+static volatile float sink;
+
+//a small fixed generator so the levels and rays are the same on every machine
+struct BenchRandom {
+    unsigned int state;
+    unsigned int next(){
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+    float range(float lo, float hi){ return lo + (hi - lo) * float(next() & 0xffffff) / float(0x1000000); }
+};
+
+struct BenchResult {
+    std::string name;
+    const char* unit;
+    long long iterations;
+    double nsPerOp;
+};
+
+static std::vector<BenchResult> results;
+static const char* filter = "";
+static double minSeconds = 0.25;
+
+//runs op(count) with a growing count until it takes at least minSeconds, op does count operations per call
+static void Run(const std::string& name, const char* unit, const std::function<void(long long count)>& op){
+    if(strstr(name.c_str(), filter) == NULL) return;
+    fprintf(stderr, "%-32s", name.c_str());
+
+    //one untimed call first so caches, scratch buffers and lazily built state are warm
+    op(1);
+
+    long long count = 1;
+    double seconds = 0;
+    for(;;){
+        auto start = std::chrono::steady_clock::now();
+        op(count);
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if(seconds >= minSeconds || count > (1ll << 40)) break;
+        //aim a bit past the target so the last run usually isn't too short
+        double scale = seconds > 0 ? minSeconds * 1.4 / seconds : 100;
+        count = (long long)(count * (scale < 100 ? (scale > 2 ? scale : 2) : 100));
+    }
+
+    BenchResult result = {name, unit, count, seconds * 1e9 / count};
+    results.push_back(result);
+    fprintf(stderr, "%14.1f ns/%s\n", result.nsPerOp, unit);
+}
+
+//a level of roughly n rectangles: a solid floor under a square area of platforms, walls and the odd spike.
+//the player starts above the middle of it so the steps spend their time colliding with something.
+static void GenerateLevel(SimWorld& world, int n, unsigned int seed){
+    clearLevel(world);
+    BenchRandom rng = {seed};
+
+    float side = 48.0f * sqrtf(float(n)) + 400.0f;
+    world.playerSpawn = Vector2 {side / 2, side / 2 - 40};
+    world.bodies.push_back(movingRect {world.playerSpawn, Vector2 {31.0f, 31.0f}, 0, 2});
+    world.playerBody = 0;
+
+    addStatic(world, 0, side, side, 50, 1);
+    addStatic(world, side / 2 - 100, side / 2, 200, 20, 1);
+    for(int i = 2; i < n; i++){
+        float x = rng.range(0, side), y = rng.range(0, side);
+        int kind = int(rng.next() % 10);
+        if(kind < 6) addStatic(world, x, y, rng.range(32, 160), 16, 1);
+        else if(kind < 9) addStatic(world, x, y, 16, rng.range(32, 128), 1);
+        else addStatic(world, x, y, 16, 16, 2);
+    }
+}
+
+//running back and forth and jumping, like the headless script but simpler
+static SimInput BenchInput(long long step){
+    SimInput input = {};
+    int phase = int(step % 480);
+    input.right = phase < 200;
+    input.left = phase >= 240 && phase < 440;
+    input.jumpPressed = step % 70 == 0;
+    input.jumpHeld = step % 70 < 35;
+    return input;
+}
+
+static void RandomRays(std::vector<Vector2>& origins, std::vector<Vector2>& dirs, int count, float side, float length, unsigned int seed){
+    BenchRandom rng = {seed};
+    origins.resize(count);
+    dirs.resize(count);
+    for(int i = 0; i < count; i++){
+        origins[i] = Vector2 {rng.range(0, side), rng.range(0, side)};
+        dirs[i] = Vector2 {rng.range(-length, length), rng.range(-length, length)};
+    }
+}
+
+static void BenchKernels(){
+    const int rayCount = 1024;
+    std::vector<Vector2> origins, dirs;
+    RandomRays(origins, dirs, rayCount, 1000, 400, 1);
+
+    BenchRandom rng = {2};
+    std::vector<movingRect> targets(rayCount);
+    RectSoA soa;
+    for(int i = 0; i < rayCount; i++){
+        targets[i] = movingRect {Vector2 {rng.range(0, 1000), rng.range(0, 1000)}, Vector2 {rng.range(8, 200), rng.range(8, 200)}, 1};
+        SoAPush(soa, targets[i].position.x, targets[i].position.y, targets[i].size.x, targets[i].size.y, 1);
+    }
+
+    Run("ray_vs_rect", "query", [&](long long count){
+        float acc = 0;
+        for(long long i = 0; i < count; i++){
+            int k = int(i & (rayCount - 1));
+            ray r = RayVsRect(origins[k], dirs[k], targets[(k * 7) & (rayCount - 1)]);
+            acc += r.collided ? r.rayCheck : 0;
+        }
+        sink = acc;
+    });
+
+    Run("dynamic_rect_vs_rect", "query", [&](long long count){
+        float acc = 0;
+        movingRect mover = {Vector2 {0, 0}, Vector2 {31, 31}, 1};
+        for(long long i = 0; i < count; i++){
+            int k = int(i & (rayCount - 1));
+            mover.position = origins[k];
+            mover.velocity = dirs[k];
+            ray r = DynamicRectVSRect(mover, targets[(k * 7) & (rayCount - 1)], 1.0f);
+            acc += r.collided ? r.rayCheck : 0;
+        }
+        sink = acc;
+    });
+
+    //one op is one rectangle tested, so it compares directly with dynamic_rect_vs_rect
+    RayBatchResult batch;
+    Run("ray_batch_per_rect", "query", [&](long long count){
+        float acc = 0;
+        long long rays = (count + rayCount - 1) / rayCount;
+        for(long long i = 0; i < rays; i++){
+            int k = int(i & (rayCount - 1));
+            acc += float(RayVsRectBatch(origins[k], dirs[k], Vector2 {31, 31}, 1.0f, soa, batch));
+        }
+        sink = acc;
+    });
+}
+
+static void BenchSteps(int n){
+    SimWorld world;
+    GenerateLevel(world, n, 3);
+    float dt = SimClock().stepDt;
+    long long step = 0;
+
+    Run("sim_step_" + std::to_string(n), "step", [&](long long count){
+        for(long long i = 0; i < count; i++, step++){
+            SimInput input = BenchInput(step);
+            if(SimPlayer(world).position.y > world.playerSpawn.y + 5000) input.respawn = true;
+            SimStep(world, input, dt);
+        }
+        sink = SimPlayer(world).position.x;
+    });
+}
+
+//n bodies dropped in a block ten high onto a floor and left to settle, then stepped while they lie there.
+//with sleeping the block is an island that's gone to sleep, so the steps cost next to nothing however many bodies there are.
+//(a tall stack takes a lot longer than this to stop moving, it's kept low so they all settle before the timing starts.)
+static void BenchBodies(int n, bool sleep){
+    SimWorld world;
+    clearLevel(world);
+    world.bodies.push_back(movingRect {Vector2 {-1000, -1000}, Vector2 {31.0f, 31.0f}, 0, 2});
+    world.playerBody = 0;
+    world.dynamics.allowSleep = sleep;
+    int columns = (n + 9) / 10;
+    addStatic(world, -100, 220, 12.0f*columns + 200, 50, 1);
+    for(int i = 0; i < n; i++) addBody(world, (i % columns)*12.0f, (i / columns)*12.0f, 10, 10, 1, 1);
+
+    float dt = SimClock().stepDt;
+    for(int i = 0; i < 600; i++) StepBodies(world, dt);
+
+    Run("bodies_at_rest_" + std::to_string(n) + (sleep ? "" : "_no_sleep"), "step", [&](long long count){
+        for(long long i = 0; i < count; i++) StepBodies(world, dt);
+        sink = world.bodies[n].position.y;
+    });
+}
+
+static void BenchQueries(int n){
+    SimWorld world;
+    GenerateLevel(world, n, 4);
+    float side = 48.0f * sqrtf(float(n)) + 400.0f;
+
+    const int rayCount = 4096;
+    std::vector<Vector2> origins, dirs;
+    RandomRays(origins, dirs, rayCount, side, 600, 5);
+
+    Run("raycast_" + std::to_string(n), "query", [&](long long count){
+        float acc = 0;
+        RaycastHit hit;
+        for(long long i = 0; i < count; i++){
+            int k = int(i & (rayCount - 1));
+            if(Raycast(world, origins[k], dirs[k], hit)) acc += hit.t;
+        }
+        sink = acc;
+    });
+
+    Run("overlap_aabb_" + std::to_string(n), "query", [&](long long count){
+        std::vector<int> found;
+        long long total = 0;
+        for(long long i = 0; i < count; i++){
+            int k = int(i & (rayCount - 1));
+            found.clear();
+            total += OverlapAABB(world, Rectangle {origins[k].x, origins[k].y, 64, 64}, found);
+        }
+        sink = float(total);
+    });
+}
+
+static void BenchLoad(int n){
+    SimWorld world;
+    GenerateLevel(world, n, 6);
+
+    const char* textFile = "bench_level.txt";
+    const char* binaryFile = "bench_level.rvl";
+    saveLevel(world, textFile);
+    saveLevelBinary(world, binaryFile);
+
+    SimWorld loaded;
+    Run("load_text_" + std::to_string(n), "load", [&](long long count){
+        for(long long i = 0; i < count; i++) loadLevel(loaded, textFile);
+        sink = float(SoACount(loaded.statics));
+    });
+    Run("load_binary_" + std::to_string(n), "load", [&](long long count){
+        for(long long i = 0; i < count; i++) loadLevel(loaded, binaryFile);
+        sink = float(SoACount(loaded.statics));
+    });
+
+    remove(textFile);
+    remove(binaryFile);
+}
+
+static const char* SimdName(){
+#if defined(__AVX__)
+    return "avx";
+#elif defined(__SSE2__)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
+
+int main(int argc, char** argv){
+    if(argc > 1) filter = argv[1];
+    if(argc > 2) minSeconds = atof(argv[2]);
+
+    BenchKernels();
+    const int sizes[] = {10, 1000, 100000};
+    for(int n : sizes) BenchSteps(n);
+    for(int n : {1000, 10000}){
+        BenchBodies(n, true);
+        BenchBodies(n, false);
+    }
+    for(int n : sizes) BenchQueries(n);
+    for(int n : sizes) BenchLoad(n);
+
+    printf("{\n  \"context\": {\"simd\": \"%s\", \"min_seconds\": %g},\n  \"benchmarks\": [\n", SimdName(), minSeconds);
+    for(size_t i = 0; i < results.size(); i++){
+        const BenchResult& r = results[i];
+        printf("    {\"name\": \"%s\", \"unit\": \"%s\", \"iterations\": %lld, \"ns_per_op\": %.3f, \"ops_per_sec\": %.1f}%s\n",
+               r.name.c_str(), r.unit, r.iterations, r.nsPerOp, 1e9 / r.nsPerOp, i + 1 < results.size() ? "," : "");
+    }
+    printf("  ]\n}\n");
+    return 0;
+}
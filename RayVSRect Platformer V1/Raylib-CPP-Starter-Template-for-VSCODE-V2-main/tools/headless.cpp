@@ -0,0 +1,158 @@
+//headless soak runner: steps the simulation core with a fixed dt and a scripted set of controls, no window needed.
+//usage: headless [frames] [level file] [dt] [trace file]
+//with no level file it runs on the default test level. a streamed level (.rvs) is streamed around the player,
+//waiting for each chunk so runs stay repeatable.
+//dt defaults to the fixed step the game runs at (SimClock::stepDt).
+//built with PROFILE=1, every step counts as a frame for the profiler and the trace file gets a chrome trace of the last ones.
+//
+//usage: headless --replay file.rvr [timings.csv]
+//plays back a recorded session (F5 in the game) frame by frame, exactly as it was played, and reports how long
+//each frame's simulation took. the final state is checked against the one saved in the recording.
+
+#include "../src/sim.h"
+#include "../src/level.h"
+#include "../src/profile.h"
+#include "../src/replay.h"
+#include "../src/stream.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <math.h>
+#include <vector>
+
+//a repeating pattern of running, jumping and sliding so every part of the movement code gets exercised
+static float ScriptPhase(int frame, float dt){
+    return fmodf(frame * dt, 8.0f);
+}
+
+static SimInput ScriptedInput(int frame, float dt){
+    SimInput input = {};
+    float phase = ScriptPhase(frame, dt);
+    float lastPhase = ScriptPhase(frame - 1, dt);
+    int jumpPeriod = std::max(1, int(0.6f / dt));
+
+    input.right = phase < 3.0f;
+    input.left = phase >= 4.0f && phase < 7.0f;
+    input.jumpPressed = frame % jumpPeriod == 0;
+    input.jumpHeld = frame % jumpPeriod < jumpPeriod / 2;
+    input.crouch = phase >= 3.0f && phase < 3.5f;
+    input.crouchPressed = input.crouch && !(lastPhase >= 3.0f && lastPhase < 3.5f);
+    input.rightPressed = input.crouch && phase >= 3.1f && lastPhase < 3.1f;
+    return input;
+}
+
+static int PlayReplay(const char* fileName, const char* timingsFile){
+    Replay replay;
+    if(!ReplayLoad(replay, fileName)) return 1;
+
+    SimWorld world;
+    SimClock clock;
+    ReplayRestart(replay, world, clock);
+
+    int frames = int(replay.frames.size());
+    std::vector<double> frameMicros(frames);
+    std::vector<int> frameSteps(frames);
+    int steps = 0;
+    for(int i = 0; i < frames; i++){
+        const ReplayFrame& frame = replay.frames[i];
+        auto start = std::chrono::steady_clock::now();
+        frameSteps[i] = SimAdvance(world, clock, ReplayUnpackInput(frame.controls), frame.frameTime);
+        frameMicros[i] = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        steps += frameSteps[i];
+        PROFILE_FRAME();
+    }
+
+    if(timingsFile != NULL){
+        FILE* csv = fopen(timingsFile, "w");
+        if(csv != NULL){
+            fprintf(csv, "frame,frame_time_ms,steps,sim_us\n");
+            for(int i = 0; i < frames; i++){
+                fprintf(csv, "%d,%.3f,%d,%.3f\n", i, replay.frames[i].frameTime * 1000.0, frameSteps[i], frameMicros[i]);
+            }
+            fclose(csv);
+        }
+        else fprintf(stderr, "couldn't write %s\n", timingsFile);
+    }
+
+    std::vector<double> sorted = frameMicros;
+    std::sort(sorted.begin(), sorted.end());
+    double total = 0;
+    for(double us : sorted) total += us;
+    int slowest = int(std::max_element(frameMicros.begin(), frameMicros.end()) - frameMicros.begin());
+
+    printf("replay: %s, frames: %d, steps: %d, step dt: %f\n", fileName, frames, steps, replay.stepDt);
+    if(frames > 0){
+        printf("sim time per frame: mean %.3f us, p50 %.3f us, p99 %.3f us, max %.3f us (frame %d, %d steps)\n",
+               total / frames, sorted[frames / 2], sorted[std::min(frames - 1, frames * 99 / 100)], sorted[frames - 1],
+               slowest, frameSteps[slowest]);
+    }
+
+    unsigned long long hash = SimStateHash(world);
+    bool match = hash == replay.finalHash;
+    printf("final state %016llx, recorded %016llx: %s\n", hash, replay.finalHash, match ? "match" : "MISMATCH");
+    return match ? 0 : 2;
+}
+
+int main(int argc, char** argv){
+    if(argc > 2 && strcmp(argv[1], "--replay") == 0) return PlayReplay(argv[2], argc > 3 ? argv[3] : NULL);
+
+    int frames = argc > 1 ? atoi(argv[1]) : 100000;
+    const char* levelFile = argc > 2 ? argv[2] : NULL;
+    //defaults to the same fixed step the game runs at
+    float dt = argc > 3 ? float(atof(argv[3])) : SimClock().stepDt;
+
+    SimWorld world;
+    LevelStream stream;
+    size_t levelLength = levelFile != NULL ? strlen(levelFile) : 0;
+    if(levelLength > 4 && strcmp(levelFile + levelLength - 4, ".rvs") == 0){
+        if(!StreamOpen(stream, world, levelFile)) return 1;
+    }
+    else if(levelFile != NULL && strcmp(levelFile, "-") != 0) loadLevel(world, levelFile);
+    else SetupDefaultLevel(world);
+
+    if(world.bodies.empty()){
+        fprintf(stderr, "level has no player rectangle\n");
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    int respawns = 0;
+    TOIStats toi;
+    for(int frame = 0; frame < frames; frame++){
+        SimInput input = ScriptedInput(frame, dt);
+
+        //the script doesn't know the level, so if it runs off an edge put the player back instead of falling forever
+        if(SimPlayer(world).position.y > world.playerSpawn.y + 10000){
+            input.respawn = true;
+            respawns++;
+        }
+        if(StreamActive(stream)){
+            const movingRect& player = SimPlayer(world);
+            StreamUpdate(stream, world, Vector2 {player.position.x + player.size.x/2, player.position.y + player.size.y/2}, true);
+        }
+        SimStep(world, input, dt);
+        toi.sweeps += world.toi.sweeps;
+        toi.movers += world.toi.movers;
+        toi.mostSweeps = std::max(toi.mostSweeps, world.toi.mostSweeps);
+        toi.capped += world.toi.capped;
+        toi.outOfBudget += world.toi.outOfBudget;
+        PROFILE_FRAME();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    const movingRect& player = SimPlayer(world);
+
+    printf("frames: %d, rects: %d, dt: %f\n", frames, SoACount(world.statics) + int(world.bodies.size()), dt);
+    printf("wall time: %f s, %.0f frames/s, %.3f us/frame\n", seconds, frames / seconds, seconds * 1e6 / frames);
+    printf("respawns: %d\n", respawns);
+    printf("extra sweeps: %d, slides: %d, most sweeps in a step: %d, capped: %d, out of budget: %d\n",
+           toi.sweeps, toi.movers, toi.mostSweeps, toi.capped, toi.outOfBudget);
+    if(StreamActive(stream)) printf("chunks streamed in: %d, out: %d\n", stream.chunksLoaded, stream.chunksUnloaded);
+    if(argc > 4 && !ProfileWriteChromeTrace(argv[4])) fprintf(stderr, "couldn't write a trace to %s (was it built with PROFILE=1?)\n", argv[4]);
+    printf("final player: x = %f, y = %f, velX = %f, velY = %f\n", player.position.x, player.position.y, player.velocity.x, player.velocity.y);
+    return 0;
+}
@@ -0,0 +1,51 @@
+//converts levels between the text format and the binary format.
+//usage: levelconv <input> <output> [chunk size]
+//the input can be either kind, an output ending in .txt is written as text, anything else as binary.
+//an output ending in .rvs is written as a streamed level cut into square chunks (1024 units wide unless given), see stream.h.
+
+#include "../src/sim.h"
+#include "../src/level.h"
+#include "../src/stream.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+static bool endsWith(const char* text, const char* suffix){
+    size_t textLength = strlen(text), suffixLength = strlen(suffix);
+    return textLength >= suffixLength && strcmp(text + textLength - suffixLength, suffix) == 0;
+}
+
+int main(int argc, char** argv){
+    if(argc < 3){
+        fprintf(stderr, "usage: levelconv <input> <output> [chunk size]\n");
+        return 1;
+    }
+
+    SimWorld world;
+    if(!loadLevel(world, argv[1])) return 1;
+    if(world.bodies.empty()){
+        fprintf(stderr, "%s has no player rectangle\n", argv[1]);
+        return 1;
+    }
+
+    bool ok = true;
+    if(endsWith(argv[2], ".txt")) ok = saveLevel(world, argv[2]);
+    else if(endsWith(argv[2], ".rvs")){
+        float chunkSize = argc > 3 ? float(atof(argv[3])) : 1024.0f;
+        if(chunkSize <= 0){
+            fprintf(stderr, "chunk size has to be positive\n");
+            return 1;
+        }
+        ok = saveLevelStreamed(world, argv[2], chunkSize);
+    }
+    else ok = saveLevelBinary(world, argv[2]);
+
+    if(!ok){
+        fprintf(stderr, "could not write %s\n", argv[2]);
+        return 1;
+    }
+
+    printf("%s -> %s (%d static rectangles)\n", argv[1], argv[2], SoACount(world.statics));
+    return 0;
+}